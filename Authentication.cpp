@@ -1,20 +1,34 @@
 #include <bits/stdc++.h>
-#include <openssl/evp.h>
 #include <nlohmann/json.hpp>
 #include "include/Authentication.h"
 #include "include/Users.h"
+#include "include/Logger.h"
+#include "include/Snapshot.h"
+#include "include/SecureRandom.h"
 using namespace std;
 using json = nlohmann::json;
 
-Authentication::Authentication(const string& db_path) : db_path_(db_path) {
+Authentication::Authentication(const string& db_path)
+    : db_path_(db_path), users_snapshot_path_(snapshot::binaryPath(db_path)) {
     // Set sessions path to be in the same directory as users database
     size_t lastSlash = db_path.find_last_of("/\\");
     string dir = (lastSlash != string::npos) ? db_path.substr(0, lastSlash + 1) : "";
     sessions_path_ = dir + "sessions.json";
+    sessions = make_unique<SessionStore>(sessions_path_);
+    const char* mode = getenv("SESSION_TOKENS");
+    if (mode && string(mode) == "signed") {
+        signedTokens = make_unique<SignedTokens>(dir + "session.key", dir + "revoked_tokens.txt", sessions->getTtl());
+    }
     
     try {
-        cout << "Loading users from: " << db_path << endl;
-        usersByUsername = UserStorage::loadUsers(db_path_);
+        auto started = chrono::steady_clock::now();
+        if (filesystem::exists(users_snapshot_path_)) {
+            usersByUsername = UserStorage::loadUsersBinary(users_snapshot_path_);
+        } else {
+            usersByUsername = UserStorage::loadUsers(db_path_);
+        }
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started);
+        LOG_INFO("Loaded " << usersByUsername.size() << " users in " << elapsed.count() << " ms");
         loadSessions();
     } catch (const exception& e) {
         throw runtime_error("Failed to initialize authentication system: " + string(e.what()));
@@ -26,24 +40,66 @@ string Authentication::login(string name, string pass) {
         throw runtime_error("Username and password cannot be empty");
     }
 
-    if (!userExists(name)) {
-        throw runtime_error("User not found");
+    string hashed, salt;
+    uint32_t iterations;
+    {
+        shared_lock<shared_mutex> lock(usersMutex);
+        auto it = usersByUsername.find(name);
+        if (it == usersByUsername.end()) {
+            throw runtime_error("User not found");
+        }
+        hashed = it->second.getPass();
+        salt = it->second.getSalt();
+        iterations = it->second.getIterations();
     }
-
-    User& user = usersByUsername[name];
-    if (!user.verifyPass(pass)) {
+    // Hash without holding the lock; it takes a while on purpose
+    if (!PasswordHasher::matches(hashed, hasher.hash(pass, salt, iterations))) {
         throw runtime_error("Invalid password");
     }
-
-    if (usersnameToToken.count(name)) {
-        return usersnameToToken[name]; // Return existing token
+    if (iterations < hasher.currentIterations()) {
+        upgradeHash(name, pass, hashed);
     }
+    return startSession(name);
+}
+
+void Authentication::upgradeHash(const string& name, const string& pass, const string& oldHash) {
+    string salt = generateSalt();
+    uint32_t iterations = hasher.currentIterations();
+    string hpass;
+    try {
+        hpass = hasher.hash(pass, salt, iterations);
+    } catch (const HasherBusyError&) {
+        return; // the next login will try again
+    }
+    {
+        unique_lock<shared_mutex> lock(usersMutex);
+        auto it = usersByUsername.find(name);
+        // Skip it if the password changed meanwhile
+        if (it == usersByUsername.end() || it->second.getPass() != oldHash) return;
+        it->second = User(name, hpass, salt, iterations);
+    }
+    saveUsersSnapshot();
+    LOG_INFO("Upgraded password hash for " << name << " to " << iterations << " iterations");
+}
+
+// Rewrites users.bin from a copy taken under a shared lock, so logins and
+// friend lookups never wait on the disk. saveMutex is taken before the copy:
+// the last save to finish always has the newest copy.
+void Authentication::saveUsersSnapshot() {
+    lock_guard<mutex> saveLock(saveMutex);
+    unordered_map<string, User> copy;
+    {
+        shared_lock<shared_mutex> lock(usersMutex);
+        copy = usersByUsername;
+    }
+    UserStorage::saveUsersBinary(copy, users_snapshot_path_);
+}
 
-    string token = generateSession();
-    sessions[token] = name;
-    usersnameToToken[name] = token;
-    saveSessions();
-    return token;
+string Authentication::startSession(const string& name) {
+    if (signedTokens) {
+        return signedTokens->issue(name);
+    }
+    return sessions->open(Symbol(name), generateSession);
 }
 
 void Authentication::signup(string name, string pass) {
@@ -65,156 +121,110 @@ void Authentication::signup(string name, string pass) {
 
     try {
         string salt = generateSalt();
-        string hpass = hashPass(pass, salt);
-        usersByUsername.emplace(name, User(name, hpass, salt));
-        UserStorage::saveUsers(usersByUsername, db_path_);
+        uint32_t iterations = hasher.currentIterations();
+        string hpass = hasher.hash(pass, salt, iterations);
+        {
+            unique_lock<shared_mutex> lock(usersMutex);
+            // Re-check under the lock in case of a concurrent signup for the same name
+            if (!usersByUsername.emplace(name, User(name, hpass, salt, iterations)).second) {
+                throw runtime_error("User already exists");
+            }
+        }
+        saveUsersSnapshot();
+    } catch (const HasherBusyError&) {
+        throw;
     } catch (const exception& e) {
         throw runtime_error("Failed to create user: " + string(e.what()));
     }
 }
 
+void Authentication::exportUsersJson(const string& path) const {
+    shared_lock<shared_mutex> lock(usersMutex);
+    UserStorage::saveUsers(usersByUsername, path);
+}
+
 void Authentication::logout(const string& token)
-        {   if(sessions.count(token)){
-            usersnameToToken.erase(sessions[token]);
-            sessions.erase(token);
-            saveSessions();
+        {
+            if (signedTokens && SignedTokens::looksSigned(token)) {
+                signedTokens->revoke(token);
+            } else {
+                sessions->close(token);
             }
         }
 
 
 User* Authentication::getUserByToken (const string& token)
         {
-            if(!isLoggedIn(token)) return nullptr;
-            else 
-                {string user=sessions[token];
-                return &usersByUsername[user];}
+            string name;
+            if (!findSession(token, name)) return nullptr;
+            // unordered_map never moves its elements, so the pointer stays valid
+            shared_lock<shared_mutex> lock(usersMutex);
+            auto it = usersByUsername.find(name);
+            return it == usersByUsername.end() ? nullptr : &it->second;
         }
 
 
 bool Authentication::isLoggedIn(const string& token) const
         {
-            return (sessions.count(token)>0);
+            string name;
+            return findSession(token, name);
         }
 
 
 string Authentication::hashPass (const string& pass, const string& salt) {
-            string input = pass + salt;
-            unsigned char hash[EVP_MAX_MD_SIZE];
-            unsigned int hash_len;
-            
-            EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-            if (!ctx) {
-                throw runtime_error("Failed to create hash context");
-            }
-            
-            if (EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) != 1 ||
-                EVP_DigestUpdate(ctx, input.c_str(), input.length()) != 1 ||
-                EVP_DigestFinal_ex(ctx, hash, &hash_len) != 1) {
-                EVP_MD_CTX_free(ctx);
-                throw runtime_error("Failed to compute hash");
-            }
-            
-            EVP_MD_CTX_free(ctx);
-
-            stringstream ss;
-            for (unsigned int i = 0; i < hash_len; i++) {
-                ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
-            }
-            return ss.str();
+            return PasswordHasher::derive(pass, salt, PasswordHasher::LEGACY);
         }
 
 
+// 22 base64url characters = 132 random bits
 string Authentication::generateSalt ()
-        {const int length = 16;
-            const char charset[] =
-                "0123456789"
-                "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                "abcdefghijklmnopqrstuvwxyz";
-            string salt;
-            for (int i = 0; i < length; i++) {
-                salt += charset[rand() % (sizeof(charset) - 1)];
-            }
-            return salt;}
+        {
+            return SecureRandom::token(22);
+        }
 
 
+// 32 base64url characters = 192 random bits; never contains a '.', which
+// keeps table tokens apart from signed ones
 string Authentication::generateSession(){
-            const int length = 32;
-            const char charset[] =
-                "0123456789"
-                "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                "abcdefghijklmnopqrstuvwxyz";
-            string token;
-            for (int i = 0; i < length; i++) {
-                token += charset[rand() % (sizeof(charset) - 1)];
-            }
-            return token;
+            return SecureRandom::token(32);
         }
 
-bool Authentication::userExists(const string& name) const {return usersByUsername.count(name);}
+bool Authentication::userExists(const string& name) const {
+    shared_lock<shared_mutex> lock(usersMutex);
+    return usersByUsername.count(name);
+}
+
+bool Authentication::findSession(const string& token, string& name) const {
+    if (SignedTokens::looksSigned(token)) {
+        return signedTokens && signedTokens->verify(token, name);
+    }
+    Symbol user;
+    if (!sessions->find(token, user)) return false;
+    name = user.str();
+    return true;
+}
 
 string Authentication::verifyToken(const string& token) {
-    if (sessions.find(token) == sessions.end()) {
+    string name;
+    if (!findSession(token, name)) {
         throw runtime_error("Invalid or expired token");
     }
-    return sessions[token];
+    return name;
 }
 
 void Authentication::loadSessions() {
-    ifstream file(sessions_path_);
-    if (!file.is_open()) {
-        cout << "No existing sessions file found, starting with empty sessions" << endl;
-        return; // File might not exist on first run
-    }
-    
-    json data;
-    // Check if the file is empty before parsing
-    file.seekg(0, ios::end);
-    if (file.tellg() == 0) {
-        cout << "Sessions file is empty" << endl;
-        return;
-    }
-    file.seekg(0, ios::beg);
-    
-    try {
-        file >> data;
-        if (data.contains("sessions")) {
-            sessions.clear();
-            usersnameToToken.clear();
-            for (const auto& session : data["sessions"]) {
-                string token = session["token"];
-                string username = session["username"];
-                sessions[token] = username;
-                usersnameToToken[username] = token;
-            }
-            cout << "Loaded " << sessions.size() << " sessions" << endl;
-        }
-    } catch (const exception& e) {
-        cout << "Error loading sessions: " << e.what() << endl;
-    }
+    sessions->load();
 }
 
 void Authentication::saveSessions() {
-    json sessions_json = json::array();
-    for (const auto& session : sessions) {
-        json session_obj;
-        session_obj["token"] = session.first;
-        session_obj["username"] = session.second;
-        sessions_json.push_back(session_obj);
-    }
-    
-    json final_json;
-    final_json["sessions"] = sessions_json;
-    
-    ofstream file(sessions_path_);
-    if (file.is_open()) {
-        file << final_json.dump(4);
-        cout << "Saved " << sessions.size() << " sessions" << endl;
-    } else {
-        cerr << "Error: Could not save sessions to " << sessions_path_ << endl;
-    }
+    sessions->compact();
 }
 
 unordered_map<string, User>& Authentication::getUsers() {
     return usersByUsername;
 }
 
+shared_mutex& Authentication::getUsersMutex() {
+    return usersMutex;
+}
+
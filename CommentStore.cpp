@@ -0,0 +1,145 @@
+#include "include/CommentStore.h"
+#include <mutex>
+#include <iterator>
+using namespace std;
+using json = nlohmann::json;
+
+//---------------------------------------------------
+//Definition of comment class methods
+//---------------------------------------------------
+Comment::Comment(int id, int pId, const string& o, string_view c)
+    : commentId(id), postId(pId), owner(o), content(ContentHeap::global().append(c)), timestamp(time(nullptr)) {}
+
+Comment::Comment(int id, int pId, Symbol o, string_view c, time_t time)
+    : commentId(id), postId(pId), owner(o), content(ContentHeap::global().append(c)), timestamp(time) {}
+
+json Comment::CommentToJson() const {
+    return {
+        {"id", commentId},
+        {"postId", postId},
+        {"owner", owner.str()},
+        {"content", string(getCommentContent())},
+        {"timestamp", timestamp}
+    };
+}
+
+Comment Comment::CommentFromJson(const json& j) {
+    Comment c(
+        j["id"],
+        j["postId"],
+        j["owner"],
+        j["content"].get<string>()
+    );
+    c.timestamp = j["timestamp"];
+    return c;
+}
+
+int Comment::getCommentId() const { return commentId; }
+string_view Comment::getCommentContent() const { return ContentHeap::global().view(content); }
+const string& Comment::getCommentOwner() const { return owner.str(); }
+time_t Comment::getCommentTimes() const { return timestamp; }
+
+void Comment::setContent(string_view c) {
+    ContentHeap::global().release(content);
+    content = ContentHeap::global().append(c);
+}
+
+void Comment::setTimestamp(time_t newTime) {
+    timestamp = newTime;
+}
+
+//---------------------------------------------------
+// CommentStore
+//---------------------------------------------------
+// unordered_map never moves its nodes, so a thread found under the shared
+// lock stays put while the caller works on it under the post's lock.
+CommentStore::Thread* CommentStore::thread(int postId) {
+    shared_lock<shared_mutex> lock(mutex);
+    auto it = threads.find(postId);
+    return it == threads.end() ? nullptr : &it->second;
+}
+
+const CommentStore::Thread* CommentStore::thread(int postId) const {
+    shared_lock<shared_mutex> lock(mutex);
+    auto it = threads.find(postId);
+    return it == threads.end() ? nullptr : &it->second;
+}
+
+void CommentStore::put(const Comment& comment) {
+    Thread* comments = thread(comment.getPostId());
+    if (!comments) {
+        unique_lock<shared_mutex> lock(mutex);
+        comments = &threads[comment.getPostId()];
+    }
+    auto result = comments->emplace(comment.getCommentId(), comment);
+    if (!result.second) {
+        ContentHeap::global().release(result.first->second.getContentRef());
+        result.first->second = comment;
+    }
+}
+
+Comment* CommentStore::find(int postId, int commentId) {
+    Thread* comments = thread(postId);
+    if (!comments) return nullptr;
+    auto it = comments->find(commentId);
+    return it == comments->end() ? nullptr : &it->second;
+}
+
+bool CommentStore::erase(int postId, int commentId) {
+    Thread* comments = thread(postId);
+    if (!comments) return false;
+    auto it = comments->find(commentId);
+    if (it == comments->end()) return false;
+    ContentHeap::global().release(it->second.getContentRef());
+    comments->erase(it);
+    return true;
+}
+
+void CommentStore::dropPost(int postId) {
+    unique_lock<shared_mutex> lock(mutex);
+    auto it = threads.find(postId);
+    if (it == threads.end()) return;
+    for (const auto& entry : it->second) {
+        ContentHeap::global().release(entry.second.getContentRef());
+    }
+    threads.erase(it);
+}
+
+void CommentStore::clear() {
+    unique_lock<shared_mutex> lock(mutex);
+    threads.clear();
+}
+
+size_t CommentStore::count(int postId) const {
+    const Thread* comments = thread(postId);
+    return comments ? comments->size() : 0;
+}
+
+vector<Comment> CommentStore::latest(int postId, size_t limit) const {
+    vector<Comment> result;
+    const Thread* comments = thread(postId);
+    if (!comments) return result;
+    auto it = comments->end();
+    size_t shown = min(limit, comments->size());
+    advance(it, -static_cast<long>(shown));
+    result.reserve(shown);
+    for (; it != comments->end(); ++it) {
+        result.push_back(it->second);
+    }
+    return result;
+}
+
+vector<Comment> CommentStore::page(int postId, int afterId, size_t limit, bool& hasMore) const {
+    vector<Comment> result;
+    hasMore = false;
+    const Thread* comments = thread(postId);
+    if (!comments) return result;
+    for (auto it = comments->upper_bound(afterId); it != comments->end(); ++it) {
+        if (result.size() == limit) {
+            hasMore = true;
+            break;
+        }
+        result.push_back(it->second);
+    }
+    return result;
+}
@@ -0,0 +1,91 @@
+#include "include/ContentHeap.h"
+#include <filesystem>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/mman.h>
+using namespace std;
+namespace fs = std::filesystem;
+
+ContentHeap::ContentHeap()
+    : segments(new atomic<char*>[MAX_SEGMENTS]), segmentSizes(new size_t[MAX_SEGMENTS]) {
+    for (size_t i = 0; i < MAX_SEGMENTS; i++) {
+        segments[i].store(nullptr, memory_order_relaxed);
+        segmentSizes[i] = 0;
+    }
+}
+
+ContentHeap::~ContentHeap() {
+    for (size_t i = 0; i < segmentCount; i++) {
+        munmap(segments[i].load(memory_order_relaxed), segmentSizes[i]);
+    }
+}
+
+ContentHeap& ContentHeap::global() {
+    static ContentHeap heap;
+    return heap;
+}
+
+// Called with appendMutex held
+size_t ContentHeap::addSegment(size_t size) {
+    if (segmentCount == MAX_SEGMENTS) {
+        throw runtime_error("Content heap is full");
+    }
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size = (size + page - 1) / page * page;
+
+    void* data = MAP_FAILED;
+    string pattern = (fs::temp_directory_path() / "cs2-content-XXXXXX").string();
+    int fd = mkstemp(pattern.data());
+    if (fd >= 0) {
+        unlink(pattern.c_str()); // the mapping keeps the file alive
+        if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+    }
+    if (data == MAP_FAILED) {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) {
+            throw runtime_error("Failed to map a content heap segment");
+        }
+    }
+
+    size_t index = segmentCount++;
+    segmentSizes[index] = size;
+    segments[index].store(static_cast<char*>(data), memory_order_release);
+    return index;
+}
+
+TextRef ContentHeap::append(string_view text) {
+    TextRef ref;
+    if (text.empty()) return ref;
+    if (text.size() > UINT32_MAX) {
+        throw runtime_error("Text too large for the content heap");
+    }
+
+    lock_guard<mutex> lock(appendMutex);
+    size_t segment;
+    size_t offset;
+    if (text.size() > SEGMENT_SIZE / 4) {
+        // Large texts get a segment of their own and leave the active one alone
+        segment = addSegment(text.size());
+        offset = 0;
+    } else {
+        if (segmentCount == 0 || activeUsed + text.size() > segmentSizes[active]) {
+            active = addSegment(SEGMENT_SIZE);
+            activeUsed = 0;
+        }
+        segment = active;
+        offset = activeUsed;
+        activeUsed += text.size();
+    }
+    memcpy(segments[segment].load(memory_order_relaxed) + offset, text.data(), text.size());
+    usedBytes.fetch_add(text.size(), memory_order_relaxed);
+
+    ref.segment = static_cast<uint32_t>(segment);
+    ref.offset = static_cast<uint32_t>(offset);
+    ref.length = static_cast<uint32_t>(text.size());
+    return ref;
+}
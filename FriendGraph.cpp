@@ -0,0 +1,190 @@
+#include "include/FriendGraph.h"
+#include <algorithm>
+using namespace std;
+
+FriendGraph::UserId FriendGraph::intern(const string& name) {
+    return intern(Symbol(name));
+}
+
+FriendGraph::UserId FriendGraph::intern(Symbol user) {
+    auto result = ids.emplace(user.id(), static_cast<UserId>(symbols.size()));
+    if (result.second) symbols.push_back(user.id());
+    return result.first->second;
+}
+
+bool FriendGraph::lookup(const string& name, UserId& id) const {
+    SymbolId symbol;
+    if (!SymbolTable::global().find(name, symbol)) return false;
+    auto it = ids.find(symbol);
+    if (it == ids.end()) return false;
+    id = it->second;
+    return true;
+}
+
+bool FriendGraph::baseHas(UserId a, UserId b) const {
+    if (a >= baseUsers()) return false;
+    auto begin = targets.begin() + offsets[a];
+    auto end = targets.begin() + offsets[a + 1];
+    return binary_search(begin, end, b);
+}
+
+bool FriendGraph::sortedContains(const unordered_map<UserId, vector<UserId>>& lists, UserId a, UserId b) {
+    auto it = lists.find(a);
+    return it != lists.end() && binary_search(it->second.begin(), it->second.end(), b);
+}
+
+void FriendGraph::sortedInsert(unordered_map<UserId, vector<UserId>>& lists, UserId a, UserId b) {
+    auto& list = lists[a];
+    list.insert(lower_bound(list.begin(), list.end(), b), b);
+}
+
+bool FriendGraph::sortedErase(unordered_map<UserId, vector<UserId>>& lists, UserId a, UserId b) {
+    auto it = lists.find(a);
+    if (it == lists.end()) return false;
+    auto pos = lower_bound(it->second.begin(), it->second.end(), b);
+    if (pos == it->second.end() || *pos != b) return false;
+    it->second.erase(pos);
+    if (it->second.empty()) lists.erase(it);
+    return true;
+}
+
+bool FriendGraph::hasEdge(UserId a, UserId b) const {
+    if (deltaEntries > 0) {
+        if (sortedContains(added, a, b)) return true;
+        if (sortedContains(removed, a, b)) return false;
+    }
+    return baseHas(a, b);
+}
+
+void FriendGraph::addDirected(UserId a, UserId b) {
+    // Re-adding an edge that is still in the base just cancels its removal
+    if (sortedErase(removed, a, b)) {
+        deltaEntries--;
+    } else {
+        sortedInsert(added, a, b);
+        deltaEntries++;
+    }
+}
+
+void FriendGraph::removeDirected(UserId a, UserId b) {
+    if (sortedErase(added, a, b)) {
+        deltaEntries--;
+    } else {
+        sortedInsert(removed, a, b);
+        deltaEntries++;
+    }
+}
+
+bool FriendGraph::addEdge(UserId a, UserId b) {
+    if (a == b || a >= userCount() || b >= userCount() || hasEdge(a, b)) return false;
+    addDirected(a, b);
+    addDirected(b, a);
+    edges++;
+    maybeCompact();
+    return true;
+}
+
+bool FriendGraph::removeEdge(UserId a, UserId b) {
+    if (a >= userCount() || b >= userCount() || !hasEdge(a, b)) return false;
+    removeDirected(a, b);
+    removeDirected(b, a);
+    edges--;
+    maybeCompact();
+    return true;
+}
+
+size_t FriendGraph::degree(UserId user) const {
+    size_t count = 0;
+    if (user < baseUsers()) count = offsets[user + 1] - offsets[user];
+    auto it = added.find(user);
+    if (it != added.end()) count += it->second.size();
+    it = removed.find(user);
+    if (it != removed.end()) count -= it->second.size();
+    return count;
+}
+
+vector<FriendGraph::UserId> FriendGraph::neighbors(UserId user) const {
+    vector<UserId> result;
+    result.reserve(degree(user));
+    forEachNeighbor(user, [&result](UserId id) { result.push_back(id); });
+    return result;
+}
+
+vector<FriendGraph::UserId> FriendGraph::mutual(UserId a, UserId b) const {
+    vector<UserId> result;
+    forEachMutual(a, {b}, [&result](size_t, UserId id) { result.push_back(id); });
+    return result;
+}
+
+vector<uint32_t> FriendGraph::mutualCounts(UserId user, const vector<UserId>& others) const {
+    vector<uint32_t> counts(others.size(), 0);
+    forEachMutual(user, others, [&counts](size_t index, UserId) { counts[index]++; });
+    return counts;
+}
+
+void FriendGraph::maybeCompact() {
+    if (deltaEntries > max(MIN_COMPACT_DELTA, targets.size() / 8)) {
+        compact();
+    }
+}
+
+void FriendGraph::compact() {
+    vector<uint32_t> newOffsets(userCount() + 1, 0);
+    for (UserId user = 0; user < userCount(); user++) {
+        newOffsets[user + 1] = newOffsets[user] + static_cast<uint32_t>(degree(user));
+    }
+    vector<UserId> newTargets(newOffsets.back());
+    for (UserId user = 0; user < userCount(); user++) {
+        UserId* out = newTargets.data() + newOffsets[user];
+        forEachNeighbor(user, [&out](UserId id) { *out++ = id; });
+    }
+    offsets.swap(newOffsets);
+    targets.swap(newTargets);
+    added.clear();
+    removed.clear();
+    deltaEntries = 0;
+}
+
+void FriendGraph::build(const vector<pair<UserId, UserId>>& edgeList) {
+    // Both directions of every edge, then sort and dedupe per user
+    vector<pair<UserId, UserId>> directed;
+    directed.reserve(edgeList.size() * 2);
+    for (const auto& edge : edgeList) {
+        if (edge.first == edge.second || edge.first >= userCount() || edge.second >= userCount()) continue;
+        directed.emplace_back(edge.first, edge.second);
+        directed.emplace_back(edge.second, edge.first);
+    }
+    sort(directed.begin(), directed.end());
+    directed.erase(unique(directed.begin(), directed.end()), directed.end());
+
+    offsets.assign(userCount() + 1, 0);
+    targets.clear();
+    targets.reserve(directed.size());
+    for (const auto& edge : directed) {
+        offsets[edge.first + 1]++;
+        targets.push_back(edge.second);
+    }
+    for (size_t i = 1; i < offsets.size(); i++) {
+        offsets[i] += offsets[i - 1];
+    }
+    added.clear();
+    removed.clear();
+    deltaEntries = 0;
+    edges = directed.size() / 2;
+}
+
+void FriendGraph::clear() {
+    offsets.assign(1, 0);
+    targets.clear();
+    added.clear();
+    removed.clear();
+    deltaEntries = 0;
+    edges = 0;
+}
+
+size_t FriendGraph::memoryBytes() const {
+    size_t bytes = offsets.capacity() * sizeof(uint32_t) + targets.capacity() * sizeof(UserId);
+    for (const auto& list : added) bytes += list.second.capacity() * sizeof(UserId);
+    for (const auto& list : removed) bytes += list.second.capacity() * sizeof(UserId);
+    return bytes;
+}
@@ -0,0 +1,113 @@
+#include "include/FriendSuggestions.h"
+#include <algorithm>
+using namespace std;
+
+namespace {
+// Ranking order: better suggestions compare less
+bool ranksBefore(const FriendSuggestion& a, const FriendSuggestion& b) {
+    if (a.mutualFriends != b.mutualFriends) return a.mutualFriends > b.mutualFriends;
+    if (a.interactions != b.interactions) return a.interactions > b.interactions;
+    return a.user < b.user;
+}
+}
+
+vector<FriendSuggestion> FriendSuggestions::compute(const FriendGraph& graph, UserId user,
+                                                    const function<bool(UserId)>& excluded) const {
+    // Mutual-friend counts by candidate id; only touched entries are reset
+    thread_local vector<uint32_t> counts;
+    thread_local vector<UserId> touched;
+    if (counts.size() < graph.userCount()) counts.resize(graph.userCount(), 0);
+    touched.clear();
+
+    graph.forEachNeighbor(user, [&](UserId friendId) {
+        graph.forEachNeighbor(friendId, [&](UserId candidate) {
+            if (counts[candidate]++ == 0) touched.push_back(candidate);
+        });
+    });
+    // Not ourselves, not people we're already friends with
+    counts[user] = 0;
+    graph.forEachNeighbor(user, [&](UserId friendId) { counts[friendId] = 0; });
+
+    vector<FriendSuggestion> ranked;
+    {
+        lock_guard<mutex> lock(interactionsMutex);
+        auto mine = interactions.find(user);
+        for (UserId candidate : touched) {
+            uint32_t mutual = counts[candidate];
+            counts[candidate] = 0;
+            if (mutual == 0 || excluded(candidate)) continue;
+            uint32_t score = 0;
+            if (mine != interactions.end()) {
+                auto it = mine->second.find(candidate);
+                if (it != mine->second.end()) score = it->second;
+            }
+            ranked.push_back({candidate, mutual, score});
+        }
+    }
+
+    if (ranked.size() > TOP_K) {
+        nth_element(ranked.begin(), ranked.begin() + TOP_K, ranked.end(), ranksBefore);
+        ranked.resize(TOP_K);
+    }
+    sort(ranked.begin(), ranked.end(), ranksBefore);
+    return ranked;
+}
+
+vector<FriendSuggestion> FriendSuggestions::top(const FriendGraph& graph, UserId user, size_t limit,
+                                                const function<bool(UserId)>& excluded) {
+    vector<FriendSuggestion> result;
+    bool cached = false;
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        auto it = cache.find(user);
+        if (it != cache.end()) {
+            result.assign(it->second.begin(), it->second.begin() + min(limit, it->second.size()));
+            cached = true;
+        }
+    }
+    if (!cached) {
+        result = compute(graph, user, excluded);
+        lock_guard<mutex> lock(cacheMutex);
+        cache[user] = result;
+    }
+    if (result.size() > limit) result.resize(limit);
+    return result;
+}
+
+void FriendSuggestions::edgeChanged(const FriendGraph& graph, UserId a, UserId b) {
+    lock_guard<mutex> lock(cacheMutex);
+    if (cache.empty()) return;
+    cache.erase(a);
+    cache.erase(b);
+    // a's friends may gain or lose b as a candidate, and the other way round
+    graph.forEachNeighbor(a, [this](UserId id) { cache.erase(id); });
+    graph.forEachNeighbor(b, [this](UserId id) { cache.erase(id); });
+}
+
+void FriendSuggestions::invalidate(UserId user) {
+    lock_guard<mutex> lock(cacheMutex);
+    cache.erase(user);
+}
+
+void FriendSuggestions::clear() {
+    lock_guard<mutex> lock(cacheMutex);
+    cache.clear();
+}
+
+void FriendSuggestions::noteInteraction(UserId actor, UserId owner) {
+    if (actor == owner) return;
+    {
+        lock_guard<mutex> lock(interactionsMutex);
+        interactions[actor][owner]++;
+    }
+    // Re-rank only if the owner is on the actor's cached list
+    lock_guard<mutex> lock(cacheMutex);
+    auto it = cache.find(actor);
+    if (it == cache.end()) return;
+    for (const auto& suggestion : it->second) {
+        if (suggestion.user == owner) {
+            cache.erase(it);
+            return;
+        }
+    }
+}
@@ -1,7 +1,6 @@
 #include "include/FriendsManager.h"
-#include "include/AVLTree.h"
+#include "include/Logger.h"
 #include <algorithm>
-#include <iostream>
 #include <fstream>
 #include <sstream>
 #include <unordered_set>
@@ -14,261 +13,567 @@ using json = nlohmann::json;
 namespace fs = std::filesystem;
 
 // Constructor: initializes with reference to existing user map
-FriendsManager::FriendsManager(unordered_map<string, User>& usersMap)
-    : users(usersMap) {}
+FriendsManager::FriendsManager(unordered_map<string, User>& usersMap, shared_mutex& usersMapMutex)
+    : users(usersMap), usersMutex(usersMapMutex) {}
+
+FriendsManager::~FriendsManager() {
+    {
+        lock_guard<mutex> lock(compactorMutex);
+        stopCompactor = true;
+    }
+    compactorCv.notify_all();
+    if (compactor.joinable()) {
+        compactor.join();
+    }
+    try {
+        if (edgeLog && edgeLog->size() > 0) {
+            compact();
+        }
+    } catch (const exception& e) {
+        LOG_ERROR("Error compacting friends edge log on shutdown: " << e.what());
+    }
+}
+
+void FriendsManager::open(const string& friendsFile, const string& pendingFile) {
+    auto started = chrono::steady_clock::now();
+    friendsPath = friendsFile;
+    pendingPath = pendingFile;
+    snapshotPath = snapshot::binaryPath(friendsFile);
+    if (fs::exists(snapshotPath)) {
+        loadBinary();
+    } else {
+        loadFriends(friendsFile);
+        loadPendingRequests(pendingFile);
+    }
+
+    edgeLog = make_unique<Journal>(friendsFile + ".wal");
+    size_t replayed;
+    {
+        unique_lock<shared_mutex> usersLock(usersMutex);
+        unique_lock<shared_mutex> pendingLock(pendingMutex);
+        replayed = edgeLog->replay([this](const json& record) { applyRecord(record); });
+    }
+    if (replayed > 0) {
+        LOG_INFO("Replayed " << replayed << " friend-graph records from " << edgeLog->getPath());
+    }
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started);
+    LOG_INFO("Loaded " << graph.edgeCount() << " friendships in " << elapsed.count() << " ms");
+    compactor = thread(&FriendsManager::compactorLoop, this);
+}
+
+void FriendsManager::logEdge(const json& record) {
+    if (edgeLog) {
+        edgeLog->append(record);
+    }
+}
+
+// Called with usersMutex and pendingMutex held exclusively. Replay must be
+// idempotent: after a crash mid-compaction the rotated log is replayed on top
+// of snapshots that already contain its effects.
+void FriendsManager::applyRecord(const json& record) {
+    const string op = record.value("op", "");
+    const string from = record.value("from", "");
+    const string to = record.value("to", "");
+    if (users.find(from) == users.end() || users.find(to) == users.end()) {
+        LOG_WARN("Skipping friend-graph record for unknown user: " << record.dump());
+        return;
+    }
+    if (op == "request") {
+        pendingRequests[Symbol(to)].insert(Symbol(from));
+    } else if (op == "request_cancel") {
+        auto it = pendingRequests.find(Symbol(to));
+        if (it != pendingRequests.end()) it->second.erase(Symbol(from));
+    } else if (op == "friend_add") {
+        auto it = pendingRequests.find(Symbol(to));
+        if (it != pendingRequests.end()) it->second.erase(Symbol(from));
+        graph.addEdge(graph.intern(from), graph.intern(to));
+    } else if (op == "friend_remove") {
+        graph.removeEdge(graph.intern(from), graph.intern(to));
+    } else {
+        LOG_WARN("Unknown friend-graph record: " << op);
+    }
+}
+
+void FriendsManager::compactorLoop() {
+    unique_lock<mutex> lock(compactorMutex);
+    while (!stopCompactor) {
+        compactorCv.wait_for(lock, compactInterval, [this] { return stopCompactor; });
+        if (stopCompactor) break;
+        if (edgeLog->size() < compactThreshold) continue;
+
+        lock.unlock();
+        try {
+            compact();
+        } catch (const exception& e) {
+            LOG_ERROR("Error compacting friends edge log: " << e.what());
+        }
+        lock.lock();
+    }
+}
+
+void FriendsManager::compact() {
+    if (!edgeLog) {
+        throw runtime_error("Friends manager was not opened with an edge log");
+    }
+    lock_guard<mutex> compactLock(compactMutex);
+
+    // Rotate while no change can slip in, so the snapshot covers exactly the rotated records
+    SnapshotWriter out;
+    {
+        shared_lock<shared_mutex> usersLock(usersMutex);
+        shared_lock<shared_mutex> pendingLock(pendingMutex);
+        edgeLog->rotate();
+        writeBinaryLocked(out);
+    }
+    out.save(snapshotPath, snapshot::FRIENDS);
+    edgeLog->dropRotated();
+    LOG_DEBUG("Compacted friend graph into " << snapshotPath);
+}
+
+void FriendsManager::invalidateSuggestions(const string& userA, const string& userB) {
+    FriendGraph::UserId id;
+    if (graph.lookup(userA, id)) suggestions.invalidate(id);
+    if (graph.lookup(userB, id)) suggestions.invalidate(id);
+}
 
 // Send a friend request from -> to
 bool FriendsManager::sendFriendRequest(const string& from, const string& to) {
+    shared_lock<shared_mutex> usersLock(usersMutex);
     // Validate users exist
     if (users.find(from) == users.end() || users.find(to) == users.end()) {
         throw runtime_error("User not found");
     }
 
     // Already friends?
-    if (areFriends(from, to)) {
-        cout << "Users are already friends" << endl;
+    unique_lock<shared_mutex> pendingLock(pendingMutex);
+    if (areFriendsLocked(from, to)) {
+        LOG_DEBUG("Users are already friends: " << from << ", " << to);
         return false;
     }
 
     // Already requested?
-    auto& pending = pendingRequests[to];
-    if (pending.count(from)) {
-        cout << "Friend request already exists" << endl;
+    Symbol sender(from);
+    auto& pending = pendingRequests[Symbol(to)];
+    if (pending.count(sender)) {
+        LOG_DEBUG("Friend request already exists from " << from << " to " << to);
         return false;
     }
 
-    pending.insert(from);
-    cout << "Added friend request from " << from << " to " << to << endl;
+    pending.insert(sender);
+    logEdge({{"op", "request"}, {"from", from}, {"to", to}});
+    invalidateSuggestions(from, to);
+    LOG_DEBUG("Added friend request from " << from << " to " << to);
     return true;
 }
 
 // Accept a friend request from -> to
 bool FriendsManager::acceptFriendRequest(const string& from, const string& to) {
-    // Validate users exist
-    if (users.find(from) == users.end() || users.find(to) == users.end()) {
-        throw runtime_error("User not found");
-    }
+    {
+        unique_lock<shared_mutex> usersLock(usersMutex);
+        // Validate users exist
+        if (users.find(from) == users.end() || users.find(to) == users.end()) {
+            throw runtime_error("User not found");
+        }
 
-    auto& pending = pendingRequests[to];
-    if (!pending.count(from)) {
-        return false;
-    }
+        unique_lock<shared_mutex> pendingLock(pendingMutex);
+        Symbol sender(from);
+        auto& pending = pendingRequests[Symbol(to)];
+        if (!pending.count(sender)) {
+            return false;
+        }
 
-    // Remove from pending requests
-    pending.erase(from);
+        // Remove from pending requests
+        pending.erase(sender);
 
-    // Add to both users' friend trees
-    try {
-        users[to].getFriendTree().insert(from);
-        users[from].getFriendTree().insert(to);
-    } catch (const exception& e) {
-        cerr << "Error adding friends: " << e.what() << endl;
-        // Rollback changes
-        users[to].getFriendTree().remove(from);
-        users[from].getFriendTree().remove(to);
-        throw;
+        FriendGraph::UserId a = graph.intern(from), b = graph.intern(to);
+        graph.addEdge(a, b);
+        suggestions.edgeChanged(graph, a, b);
+        logEdge({{"op", "friend_add"}, {"from", from}, {"to", to}});
     }
 
+    notifyFriendship(from, to, true);
     return true;
 }
 
 // Reject a friend request from -> to
 bool FriendsManager::rejectFriendRequest(const string& from, const string& to) {
+    shared_lock<shared_mutex> usersLock(usersMutex);
     // Validate users exist
     if (users.find(from) == users.end() || users.find(to) == users.end()) {
         throw runtime_error("User not found");
     }
 
-    auto& pending = pendingRequests[to];
-    if (!pending.count(from)) {
+    unique_lock<shared_mutex> pendingLock(pendingMutex);
+    Symbol sender(from);
+    auto& pending = pendingRequests[Symbol(to)];
+    if (!pending.count(sender)) {
         return false;
     }
 
-    pending.erase(from);
+    pending.erase(sender);
+    logEdge({{"op", "request_cancel"}, {"from", from}, {"to", to}});
+    invalidateSuggestions(from, to);
     return true;
 }
 
 // Cancel a friend request sent from 'from' to 'to'
 bool FriendsManager::cancelFriendRequest(const string& from, const string& to) {
+    shared_lock<shared_mutex> usersLock(usersMutex);
     // Validate users exist
     if (users.find(from) == users.end() || users.find(to) == users.end()) {
         throw runtime_error("User not found");
     }
 
-    auto& pending = pendingRequests[to];
-    if (!pending.count(from)) {
+    unique_lock<shared_mutex> pendingLock(pendingMutex);
+    Symbol sender(from);
+    auto& pending = pendingRequests[Symbol(to)];
+    if (!pending.count(sender)) {
         return false;
     }
 
-    pending.erase(from);
+    pending.erase(sender);
+    logEdge({{"op", "request_cancel"}, {"from", from}, {"to", to}});
+    invalidateSuggestions(from, to);
     return true;
 }
 
 // Remove 'friendName' from 'username's friend list and vice versa
 bool FriendsManager::removeFriend(const string& username, const string& friendName) {
-    // Validate users exist
-    if (users.find(username) == users.end() || users.find(friendName) == users.end()) {
-        throw runtime_error("User not found");
-    }
+    {
+        unique_lock<shared_mutex> usersLock(usersMutex);
+        // Validate users exist
+        if (users.find(username) == users.end() || users.find(friendName) == users.end()) {
+            throw runtime_error("User not found");
+        }
 
-    // Check if they are friends
-    if (!areFriends(username, friendName)) {
-        return false;
-    }
+        // Check if they are friends
+        if (!areFriendsLocked(username, friendName)) {
+            return false;
+        }
 
-    try {
-        users[username].getFriendTree().remove(friendName);
-        users[friendName].getFriendTree().remove(username);
-    } catch (const exception& e) {
-        cerr << "Error removing friends: " << e.what() << endl;
-        throw;
+        FriendGraph::UserId a = graph.intern(username), b = graph.intern(friendName);
+        graph.removeEdge(a, b);
+        suggestions.edgeChanged(graph, a, b);
+        logEdge({{"op", "friend_remove"}, {"from", username}, {"to", friendName}});
     }
 
+    notifyFriendship(username, friendName, false);
     return true;
 }
 
-// Get a list of friends (in-order traversal of AVL tree)
+void FriendsManager::setFriendshipListener(function<void(const string&, const string&, bool)> listener) {
+    friendshipListener = move(listener);
+}
+
+// Runs without our locks held so listeners are free to query us
+void FriendsManager::notifyFriendship(const string& userA, const string& userB, bool added) {
+    if (friendshipListener) {
+        friendshipListener(userA, userB, added);
+    }
+}
+
+// Get a list of friends, sorted by name
 vector<string> FriendsManager::getFriendList(const string& username) const {
+    shared_lock<shared_mutex> usersLock(usersMutex);
     if (users.find(username) == users.end()) {
         throw runtime_error("User not found");
     }
-    return users.at(username).getFriendTree().inOrder();
+    return friendNamesLocked(username);
+}
+
+vector<string> FriendsManager::getFriendPage(const string& username, const string& after,
+                                             size_t limit, bool& hasMore) const {
+    hasMore = false;
+    shared_lock<shared_mutex> usersLock(usersMutex);
+    if (users.find(username) == users.end()) {
+        throw runtime_error("User not found");
+    }
+    vector<const string*> names;
+    FriendGraph::UserId id;
+    if (!graph.lookup(username, id)) return {};
+    graph.forEachNeighbor(id, [&](FriendGraph::UserId friendId) {
+        const string& name = graph.name(friendId);
+        if (name > after) names.push_back(&name);
+    });
+
+    auto byName = [](const string* a, const string* b) { return *a < *b; };
+    if (names.size() > limit) {
+        hasMore = true;
+        nth_element(names.begin(), names.begin() + limit, names.end(), byName);
+        names.resize(limit);
+    }
+    sort(names.begin(), names.end(), byName);
+
+    vector<string> page;
+    page.reserve(names.size());
+    for (const string* name : names) page.push_back(*name);
+    return page;
+}
+
+vector<string> FriendsManager::friendNamesLocked(const string& username) const {
+    vector<string> names;
+    FriendGraph::UserId id;
+    if (!graph.lookup(username, id)) return names;
+    names.reserve(graph.degree(id));
+    graph.forEachNeighbor(id, [&](FriendGraph::UserId friendId) { names.push_back(graph.name(friendId)); });
+    sort(names.begin(), names.end());
+    return names;
 }
 
 // Get pending requests for a user
 vector<string> FriendsManager::getPendingRequests(const string& username) const {
+    shared_lock<shared_mutex> usersLock(usersMutex);
     if (users.find(username) == users.end()) {
         throw runtime_error("User not found");
     }
-    if (!pendingRequests.count(username)) return {};
-    const auto& set = pendingRequests.at(username);
-    return vector<string>(set.begin(), set.end());
+    shared_lock<shared_mutex> pendingLock(pendingMutex);
+    auto it = pendingRequests.find(Symbol(username));
+    if (it == pendingRequests.end()) return {};
+    vector<string> senders;
+    senders.reserve(it->second.size());
+    for (const Symbol& sender : it->second) {
+        senders.push_back(sender.str());
+    }
+    return senders;
 }
 
 // Check if two users are friends
 bool FriendsManager::areFriends(const string& userA, const string& userB) const {
+    shared_lock<shared_mutex> usersLock(usersMutex);
+    return areFriendsLocked(userA, userB);
+}
+
+bool FriendsManager::areFriendsLocked(const string& userA, const string& userB) const {
     if (users.find(userA) == users.end() || users.find(userB) == users.end()) {
         throw runtime_error("User not found");
     }
-    return users.at(userA).getFriendTree().contains(userB);
+    FriendGraph::UserId idA, idB;
+    return graph.lookup(userA, idA) && graph.lookup(userB, idB) && graph.hasEdge(idA, idB);
 }
 
-// Get mutual friends
+// Get mutual friends (sorted by name)
 vector<string> FriendsManager::getMutualFriends(const string& userA, const string& userB) const {
+    shared_lock<shared_mutex> usersLock(usersMutex);
+    if (users.find(userA) == users.end() || users.find(userB) == users.end()) {
+        throw runtime_error("User not found");
+    }
+    vector<string> mutual;
+    FriendGraph::UserId idA, idB;
+    if (!graph.lookup(userA, idA) || !graph.lookup(userB, idB)) return mutual;
+    for (FriendGraph::UserId id : graph.mutual(idA, idB)) {
+        mutual.push_back(graph.name(id));
+    }
+    sort(mutual.begin(), mutual.end());
+    return mutual;
+}
 
-    const auto listA = users.at(userA).getFriendTree().inOrder();
-    const auto listB = users.at(userB).getFriendTree().inOrder();
+vector<MutualFriends> FriendsManager::getMutualFriendsBatch(const string& username, const vector<string>& others,
+                                                           bool withNames) const {
+    shared_lock<shared_mutex> usersLock(usersMutex);
+    if (users.find(username) == users.end()) {
+        throw runtime_error("User not found");
+    }
+    vector<MutualFriends> result(others.size());
+    vector<FriendGraph::UserId> ids(others.size(), UINT32_MAX);
+    for (size_t i = 0; i < others.size(); i++) {
+        result[i].user = others[i];
+        // Unknown users keep an id past the graph, which forEachMutual skips
+        graph.lookup(others[i], ids[i]);
+    }
+    FriendGraph::UserId self;
+    if (!graph.lookup(username, self)) return result;
+
+    graph.forEachMutual(self, ids, [&](size_t index, FriendGraph::UserId id) {
+        result[index].count++;
+        if (withNames) result[index].names.push_back(graph.name(id));
+    });
+    if (withNames) {
+        for (auto& entry : result) sort(entry.names.begin(), entry.names.end());
+    }
+    return result;
+}
 
-    unordered_set<string> setA(listA.begin(), listA.end());
-    vector<string> mutual;
+// Suggest friends based on 2nd-degree connections, best first
+vector<pair<string, uint32_t>> FriendsManager::suggestFriends(const string& username, size_t limit) {
+    // Held until the list is cached, so no change can slip in between
+    // computing it and caching it
+    shared_lock<shared_mutex> usersLock(usersMutex);
+    shared_lock<shared_mutex> pendingLock(pendingMutex);
+    FriendGraph::UserId self;
+    if (!users.count(username) || !graph.lookup(username, self)) return {};
+
+    Symbol me = graph.symbol(self);
+    auto received = pendingRequests.find(me);
+    auto pending = [&](FriendGraph::UserId candidate) {
+        Symbol other = graph.symbol(candidate);
+        if (received != pendingRequests.end() && received->second.count(other)) return true;
+        auto sent = pendingRequests.find(other);
+        return sent != pendingRequests.end() && sent->second.count(me) > 0;
+    };
+
+    vector<pair<string, uint32_t>> result;
+    for (const FriendSuggestion& suggestion : suggestions.top(graph, self, limit, pending)) {
+        result.emplace_back(graph.name(suggestion.user), suggestion.mutualFriends);
+    }
+    return result;
+}
 
-    for (int i = 0; i < listB.size(); i++) {
-    string name = listB[i];
-    if (setA.count(name)) {
-        mutual.push_back(name);
+void FriendsManager::noteInteraction(const string& actor, const string& owner) {
+    shared_lock<shared_mutex> usersLock(usersMutex);
+    FriendGraph::UserId actorId, ownerId;
+    if (graph.lookup(actor, actorId) && graph.lookup(owner, ownerId)) {
+        suggestions.noteInteraction(actorId, ownerId);
     }
 }
-    return mutual;
+
+json FriendsManager::friendsToJsonLocked() const {
+    json j = json::object();
+    for (const auto& pair : users) {
+        j[pair.first] = friendNamesLocked(pair.first);
+    }
+    return j;
 }
 
-// Suggest friends based on 2nd-degree connections
-vector<string> FriendsManager::suggestFriends(const string& username) const {
-    if (!users.count(username)) return {};
+json FriendsManager::pendingToJsonLocked() const {
+    json j = json::object();
+    for (const auto& pair : pendingRequests) {
+        if (pair.second.empty()) continue;
+        vector<string> senders;
+        for (const Symbol& sender : pair.second) {
+            senders.push_back(sender.str());
+        }
+        j[pair.first.str()] = senders;
+    }
+    return j;
+}
 
-    const auto& user = users.at(username);
-    const auto directFriends = user.getFriendTree().inOrder();
-    unordered_set<string> suggestionsSet;
+// Binary layout: edge count and each friendship once (lower id first), then
+// pending requests as receiver, sender count, senders
+void FriendsManager::writeBinaryLocked(SnapshotWriter& out) const {
+    vector<pair<FriendGraph::UserId, FriendGraph::UserId>> edges;
+    edges.reserve(graph.edgeCount());
+    for (FriendGraph::UserId user = 0; user < graph.userCount(); user++) {
+        graph.forEachNeighbor(user, [&](FriendGraph::UserId friendId) {
+            if (user < friendId) edges.emplace_back(user, friendId);
+        });
+    }
+    out.u32(static_cast<uint32_t>(edges.size()));
+    for (const auto& edge : edges) {
+        out.symbol(graph.symbol(edge.first));
+        out.symbol(graph.symbol(edge.second));
+    }
+
+    uint32_t receivers = 0;
+    for (const auto& pair : pendingRequests) {
+        if (!pair.second.empty()) receivers++;
+    }
+    out.u32(receivers);
+    for (const auto& pair : pendingRequests) {
+        if (pair.second.empty()) continue;
+        out.symbol(pair.first);
+        out.u32(static_cast<uint32_t>(pair.second.size()));
+        for (const Symbol& sender : pair.second) {
+            out.symbol(sender);
+        }
+    }
+}
 
-    for (int i =0; i< directFriends.size(); i++) {
-        string friendName = directFriends[i];
-        const auto secondDegree = users.at(friendName).getFriendTree().inOrder();
-        for (int j = 0; j < secondDegree.size(); j++) {
-            string potential = secondDegree[j];
-            if (potential == username) continue;
-            if (!user.getFriendTree().contains(potential)) {
-                suggestionsSet.insert(potential);
+void FriendsManager::loadBinary() {
+    unique_lock<shared_mutex> usersLock(usersMutex);
+    unique_lock<shared_mutex> pendingLock(pendingMutex);
+    SnapshotReader in(snapshotPath, snapshot::FRIENDS);
+    auto known = [this](Symbol user) { return users.find(user.str()) != users.end(); };
+
+    uint32_t edgeCount = in.u32();
+    vector<pair<FriendGraph::UserId, FriendGraph::UserId>> edges;
+    edges.reserve(edgeCount);
+    for (uint32_t i = 0; i < edgeCount; i++) {
+        Symbol a = in.symbol();
+        Symbol b = in.symbol();
+        if (!known(a) || !known(b)) {
+            LOG_WARN("Skipping friendship with unknown user: " << a.str() << " - " << b.str());
+            continue;
+        }
+        edges.emplace_back(graph.intern(a), graph.intern(b));
+    }
+    graph.build(edges);
+    suggestions.clear();
+
+    uint32_t receivers = in.u32();
+    for (uint32_t i = 0; i < receivers; i++) {
+        Symbol receiver = in.symbol();
+        uint32_t senders = in.u32();
+        for (uint32_t s = 0; s < senders; s++) {
+            Symbol sender = in.symbol();
+            if (known(receiver) && known(sender)) {
+                pendingRequests[receiver].insert(sender);
             }
         }
     }
+    if (!in.done()) {
+        throw runtime_error("Trailing data in friends snapshot: " + snapshotPath);
+    }
+}
 
-    return vector<string>(suggestionsSet.begin(), suggestionsSet.end());
+// Write next to the old file, sync it and swap it in, so a crash never leaves a half-written snapshot
+void FriendsManager::writeSnapshot(const string& filename, const json& data) {
+    snapshot::replaceFile(filename, {data.dump(4)});
 }
 
 // Save all friends to a JSON file
 void FriendsManager::saveFriends(const std::string& filename) {
     try {
-        // Create directory if it doesn't exist
-        fs::path filePath(filename);
-        fs::create_directories(filePath.parent_path());
-
         json j;
-        for (const auto& pair : users) {
-            const string& username = pair.first;
-            vector<string> friends = pair.second.getFriendTree().inOrder();
-            j[username] = friends;
-        }
-
-        ofstream file(filename);
-        if (!file.is_open()) {
-            throw runtime_error("Failed to open friends file for writing: " + filename);
-        }
-
-        file << j.dump(4);
-        file.close();
-
-        if (file.fail()) {
-            throw runtime_error("Failed to write to friends file: " + filename);
-        }
-
-        cout << "Successfully saved friends to: " << filename << endl;
-        cout << "Current friends:" << endl;
-        for (const auto& pair : users) {
-            cout << "  " << pair.first << " has friends: ";
-            for (const auto& friend_name : pair.second.getFriendTree().inOrder()) {
-                cout << friend_name << " ";
-            }
-            cout << endl;
+        {
+            shared_lock<shared_mutex> usersLock(usersMutex);
+            j = friendsToJsonLocked();
         }
+        writeSnapshot(filename, j);
+        LOG_DEBUG("Saved friends of " << j.size() << " users to: " << filename);
     } catch (const exception& e) {
-        cerr << "Error saving friends: " << e.what() << endl;
+        LOG_ERROR("Error saving friends: " << e.what());
         throw;
     }
 }
 
 // Load all friends from a JSON file
 void FriendsManager::loadFriends(const std::string& filename) {
+    unique_lock<shared_mutex> usersLock(usersMutex);
     try {
         ifstream file(filename);
         if (!file.is_open()) {
-            cerr << "Warning: Friends file does not exist: " << filename << endl;
+            LOG_WARN("Friends file does not exist: " << filename);
             return;
         }
 
         json j;
         file >> j;
 
-        cout << "Loading friends from: " << filename << endl;
+        LOG_INFO("Loading friends from: " << filename);
+        // Collect every edge first and build the adjacency arrays in one pass
+        vector<pair<FriendGraph::UserId, FriendGraph::UserId>> edges;
         for (auto it = j.begin(); it != j.end(); ++it) {
             const string& username = it.key();
             if (users.find(username) == users.end()) {
-                cerr << "Warning: Skipping unknown user: " << username << endl;
+                LOG_WARN("Skipping unknown user: " << username);
                 continue;
             }
 
+            FriendGraph::UserId userId = graph.intern(username);
             const json& friendList = it.value();
-            cout << "  Loading friends for " << username << ": ";
             for (const auto& friendName : friendList) {
                 if (users.find(friendName) != users.end()) {
-                    users[username].getFriendTree().insert(friendName);
-                    cout << friendName << " ";
+                    edges.emplace_back(userId, graph.intern(friendName));
                 } else {
-                    cerr << "\n  Warning: Skipping unknown friend: " << friendName << " for user: " << username << endl;
+                    LOG_WARN("Skipping unknown friend: " << friendName << " for user: " << username);
                 }
             }
-            cout << endl;
         }
+        graph.build(edges);
+        suggestions.clear();
+        LOG_INFO("Loaded " << graph.edgeCount() << " friendships");
     } catch (const exception& e) {
-        cerr << "Error loading friends: " << e.what() << endl;
+        LOG_ERROR("Error loading friends: " << e.what());
         throw;
     }
 }
@@ -276,85 +581,61 @@ void FriendsManager::loadFriends(const std::string& filename) {
 // Save pending requests to a JSON file
 void FriendsManager::savePendingRequests(const std::string& filename) {
     try {
-        // Create directory if it doesn't exist
-        fs::path filePath(filename);
-        fs::create_directories(filePath.parent_path());
-
         json j;
-        for (const auto& pair : pendingRequests) {
-            const string& receiver = pair.first;
-            const unordered_set<string>& senders = pair.second;
-            j[receiver] = vector<string>(senders.begin(), senders.end());
-        }
-
-        ofstream file(filename);
-        if (!file.is_open()) {
-            throw runtime_error("Failed to open pending requests file for writing: " + filename);
-        }
-
-        file << j.dump(4);
-        file.close();
-
-        if (file.fail()) {
-            throw runtime_error("Failed to write to pending requests file: " + filename);
-        }
-
-        cout << "Successfully saved pending requests to: " << filename << endl;
-        cout << "Current pending requests:" << endl;
-        for (const auto& pair : pendingRequests) {
-            cout << "  " << pair.first << " has requests from: ";
-            for (const auto& sender : pair.second) {
-                cout << sender << " ";
-            }
-            cout << endl;
+        {
+            shared_lock<shared_mutex> pendingLock(pendingMutex);
+            j = pendingToJsonLocked();
         }
+        writeSnapshot(filename, j);
+        LOG_DEBUG("Saved pending requests of " << j.size() << " users to: " << filename);
     } catch (const exception& e) {
-        cerr << "Error saving pending requests: " << e.what() << endl;
+        LOG_ERROR("Error saving pending requests: " << e.what());
         throw;
     }
 }
 
 // Load pending requests from a JSON file
 void FriendsManager::loadPendingRequests(const std::string& filename) {
+    shared_lock<shared_mutex> usersLock(usersMutex);
+    unique_lock<shared_mutex> pendingLock(pendingMutex);
     try {
         ifstream file(filename);
         if (!file.is_open()) {
-            cerr << "Warning: Pending requests file does not exist: " << filename << endl;
+            LOG_WARN("Pending requests file does not exist: " << filename);
             return;
         }
 
         json j;
         file >> j;
 
-        cout << "Loading pending requests from: " << filename << endl;
+        LOG_INFO("Loading pending requests from: " << filename);
         for (auto it = j.begin(); it != j.end(); ++it) {
             const string& receiver = it.key();
             if (users.find(receiver) == users.end()) {
-                cerr << "Warning: Skipping unknown receiver: " << receiver << endl;
+                LOG_WARN("Skipping unknown receiver: " << receiver);
                 continue;
             }
 
             const json& senders = it.value();
-            cout << "  Loading requests for " << receiver << ": ";
             for (const auto& sender : senders) {
                 if (users.find(sender) != users.end()) {
-                    pendingRequests[receiver].insert(sender);
-                    cout << sender << " ";
+                    pendingRequests[Symbol(receiver)].insert(Symbol(sender.get<string>()));
                 } else {
-                    cerr << "\n  Warning: Skipping unknown sender: " << sender << " for receiver: " << receiver << endl;
+                    LOG_WARN("Skipping unknown sender: " << sender << " for receiver: " << receiver);
                 }
             }
-            cout << endl;
         }
     } catch (const exception& e) {
-        cerr << "Error loading pending requests: " << e.what() << endl;
+        LOG_ERROR("Error loading pending requests: " << e.what());
         throw;
     }
 }
 
 int FriendsManager::getFriendCount(const std::string& username) const {
+    shared_lock<shared_mutex> usersLock(usersMutex);
     if (users.find(username) == users.end()) {
         throw runtime_error("User not found");
     }
-    return users.at(username).getFriendTree().size();
+    FriendGraph::UserId id;
+    return graph.lookup(username, id) ? static_cast<int>(graph.degree(id)) : 0;
 }
\ No newline at end of file
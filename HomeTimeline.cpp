@@ -0,0 +1,208 @@
+#include "include/HomeTimeline.h"
+#include <algorithm>
+#include <mutex>
+using namespace std;
+
+//------------------------------------------------------------
+// PostIdRing
+//------------------------------------------------------------
+PostIdRing::PostIdRing(size_t cap) : buffer(cap), capacity(cap) {}
+
+void PostIdRing::push(int postId) {
+    if (capacity == 0) {
+        dropped = max(dropped, postId);
+        return;
+    }
+    // Fan-out happens outside the posts lock, so ids can arrive slightly out of order
+    if (count > 0 && postId <= slot(count - 1)) {
+        vector<int> ids = toVector();
+        auto it = lower_bound(ids.begin(), ids.end(), postId);
+        if (it != ids.end() && *it == postId) return;
+        ids.insert(it, postId);
+        assign(ids);
+        return;
+    }
+    if (count == capacity) {
+        dropped = max(dropped, buffer[head]);
+        buffer[head] = postId;
+        head = (head + 1) % capacity;
+    } else {
+        slot(count) = postId;
+        count++;
+    }
+}
+
+void PostIdRing::assign(const vector<int>& ascending) {
+    size_t skip = ascending.size() > capacity ? ascending.size() - capacity : 0;
+    if (skip > 0) dropped = max(dropped, ascending[skip - 1]);
+    head = 0;
+    count = ascending.size() - skip;
+    copy(ascending.begin() + skip, ascending.end(), buffer.begin());
+}
+
+void PostIdRing::remove(int postId) {
+    vector<int> ids = toVector();
+    auto it = lower_bound(ids.begin(), ids.end(), postId);
+    if (it == ids.end() || *it != postId) return;
+    ids.erase(it);
+    assign(ids);
+}
+
+void PostIdRing::removeAll(const unordered_set<int>& postIds) {
+    vector<int> ids = toVector();
+    ids.erase(remove_if(ids.begin(), ids.end(),
+        [&postIds](int id) { return postIds.count(id) > 0; }), ids.end());
+    assign(ids);
+}
+
+void PostIdRing::merge(const PostIdRing& other) {
+    dropped = max(dropped, other.dropped);
+    vector<int> ids = toVector();
+    vector<int> ascending = other.toVector();
+    vector<int> merged;
+    merged.reserve(ids.size() + ascending.size());
+    set_union(ids.begin(), ids.end(), ascending.begin(), ascending.end(), back_inserter(merged));
+    assign(merged);
+}
+
+vector<int> PostIdRing::toVector() const {
+    vector<int> ids;
+    ids.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        ids.push_back(slot(i));
+    }
+    return ids;
+}
+
+void PostIdRing::newest(size_t limit, int beforeId, vector<int>& out) const {
+    size_t taken = 0;
+    for (size_t i = count; i-- > 0 && taken < limit;) {
+        int id = slot(i);
+        if (id >= beforeId) continue;
+        out.push_back(id);
+        taken++;
+    }
+}
+
+//------------------------------------------------------------
+// HomeTimelines
+//------------------------------------------------------------
+HomeTimelines::HomeTimelines(size_t cap, size_t limit) : capacity(cap), fanoutLimit(limit) {}
+
+PostIdRing& HomeTimelines::ring(unordered_map<string, PostIdRing>& rings, const string& user) {
+    auto it = rings.find(user);
+    if (it == rings.end()) {
+        it = rings.emplace(user, PostIdRing(capacity)).first;
+    }
+    return it->second;
+}
+
+void HomeTimelines::addPost(const string& author, int postId, const vector<string>& friends) {
+    unique_lock<shared_mutex> lock(mutex);
+    ring(authored, author).push(postId);
+    ring(inboxes, author).push(postId);
+
+    if (friends.size() > fanoutLimit) {
+        // Too expensive to push; friends pull this author's ring when they read
+        highFanoutAuthors.insert(author);
+        return;
+    }
+    if (highFanoutAuthors.erase(author)) {
+        // Friends only ever pulled this author's posts, so none of them are in
+        // their inboxes: copy the recent ones in (this post included)
+        const PostIdRing& own = ring(authored, author);
+        for (const auto& friendName : friends) {
+            ring(inboxes, friendName).merge(own);
+        }
+        return;
+    }
+    for (const auto& friendName : friends) {
+        ring(inboxes, friendName).push(postId);
+    }
+}
+
+void HomeTimelines::removePost(const string& author, int postId, const vector<string>& friends) {
+    unique_lock<shared_mutex> lock(mutex);
+    auto own = authored.find(author);
+    if (own != authored.end()) own->second.remove(postId);
+    auto inbox = inboxes.find(author);
+    if (inbox != inboxes.end()) inbox->second.remove(postId);
+    for (const auto& friendName : friends) {
+        auto it = inboxes.find(friendName);
+        if (it != inboxes.end()) it->second.remove(postId);
+    }
+}
+
+void HomeTimelines::addFriendship(const string& userA, const string& userB) {
+    unique_lock<shared_mutex> lock(mutex);
+    // Backfill each inbox with the new friend's recent posts
+    auto backfill = [this](const string& reader, const string& author) {
+        if (highFanoutAuthors.count(author)) return; // pulled at read time anyway
+        auto own = authored.find(author);
+        if (own == authored.end()) return;
+        ring(inboxes, reader).merge(own->second);
+    };
+    backfill(userA, userB);
+    backfill(userB, userA);
+}
+
+void HomeTimelines::removeFriendship(const string& userA, const string& userB) {
+    unique_lock<shared_mutex> lock(mutex);
+    auto purge = [this](const string& reader, const string& author) {
+        auto own = authored.find(author);
+        auto inbox = inboxes.find(reader);
+        if (own == authored.end() || inbox == inboxes.end()) return;
+        vector<int> ids = own->second.toVector();
+        inbox->second.removeAll(unordered_set<int>(ids.begin(), ids.end()));
+    };
+    purge(userA, userB);
+    purge(userB, userA);
+}
+
+void HomeTimelines::clear() {
+    unique_lock<shared_mutex> lock(mutex);
+    inboxes.clear();
+    authored.clear();
+    highFanoutAuthors.clear();
+}
+
+vector<int> HomeTimelines::read(const string& username, const vector<string>& friends,
+                                size_t limit, int beforeId, int& floor) const {
+    shared_lock<shared_mutex> lock(mutex);
+    vector<int> ids;
+    floor = 0;
+    auto inbox = inboxes.find(username);
+    if (inbox != inboxes.end()) {
+        inbox->second.newest(limit, beforeId, ids);
+        floor = inbox->second.floor();
+    }
+
+    // Fan-out-on-read for friends who are too widely connected to push
+    bool merged = false;
+    auto pull = [&](const string& author) {
+        auto own = authored.find(author);
+        if (own == authored.end()) return;
+        own->second.newest(limit, beforeId, ids);
+        floor = max(floor, own->second.floor());
+        merged = true;
+    };
+    if (highFanoutAuthors.size() < friends.size()) {
+        for (const auto& author : highFanoutAuthors) {
+            if (binary_search(friends.begin(), friends.end(), author)) pull(author);
+        }
+    } else {
+        for (const auto& friendName : friends) {
+            if (highFanoutAuthors.count(friendName)) pull(friendName);
+        }
+    }
+
+    if (merged) {
+        sort(ids.begin(), ids.end(), greater<int>());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+        if (ids.size() > limit) ids.resize(limit);
+    }
+    // Below the highest floor some ring may be missing posts, so none of
+    // those ids can be vouched for
+    while (!ids.empty() && ids.back() <= floor) ids.pop_back();
+    return ids;
+}
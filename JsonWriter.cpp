@@ -0,0 +1,98 @@
+#include "include/JsonWriter.h"
+#include <charconv>
+using namespace std;
+
+JsonWriter::JsonWriter(string& target) : out(target) {}
+
+void JsonWriter::separator() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (!needsComma.empty()) {
+        if (needsComma.back()) out += ',';
+        needsComma.back() = true;
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separator();
+    out += '{';
+    needsComma.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out += '}';
+    needsComma.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separator();
+    out += '[';
+    needsComma.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    out += ']';
+    needsComma.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(string_view name) {
+    separator();
+    appendEscaped(out, name);
+    out += ':';
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(string_view text) {
+    separator();
+    appendEscaped(out, text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(long long number) {
+    separator();
+    char buf[24];
+    auto result = to_chars(buf, buf + sizeof(buf), number);
+    out.append(buf, result.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separator();
+    out += flag ? "true" : "false";
+    return *this;
+}
+
+void JsonWriter::appendEscaped(string& target, string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    target += '"';
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = text[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        // Copy the clean run in one go, then the escape
+        target.append(text.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"': target += "\\\""; break;
+            case '\\': target += "\\\\"; break;
+            case '\n': target += "\\n"; break;
+            case '\r': target += "\\r"; break;
+            case '\t': target += "\\t"; break;
+            case '\b': target += "\\b"; break;
+            case '\f': target += "\\f"; break;
+            default:
+                target += "\\u00";
+                target += hex[c >> 4];
+                target += hex[c & 0xf];
+        }
+    }
+    target.append(text.data() + runStart, text.size() - runStart);
+    target += '"';
+}
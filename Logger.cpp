@@ -0,0 +1,125 @@
+#include "include/Logger.h"
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
+using namespace std;
+
+Logger::Logger() : ring(new Entry[CAPACITY]), minLevel(static_cast<int>(LogLevel::Info)) {
+    for (size_t i = 0; i < CAPACITY; i++) {
+        ring[i].sequence.store(i, memory_order_relaxed);
+    }
+    LogLevel level;
+    if (const char* env = getenv("LOG_LEVEL")) {
+        if (parseLevel(env, level)) setLevel(level);
+    }
+    flusher = thread(&Logger::flushLoop, this);
+}
+
+Logger::~Logger() {
+    running.store(false);
+    if (flusher.joinable()) flusher.join();
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+bool Logger::parseLevel(const string& name, LogLevel& level) {
+    string lower(name);
+    transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return tolower(c); });
+    if (lower == "debug") level = LogLevel::Debug;
+    else if (lower == "info") level = LogLevel::Info;
+    else if (lower == "warn" || lower == "warning") level = LogLevel::Warn;
+    else if (lower == "error") level = LogLevel::Error;
+    else if (lower == "off" || lower == "none") level = LogLevel::Off;
+    else return false;
+    return true;
+}
+
+void Logger::log(LogLevel level, string message) {
+    // Bounded MPSC queue: each cell's sequence says whose turn it is
+    size_t pos = enqueuePos.load(memory_order_relaxed);
+    Entry* entry;
+    for (;;) {
+        entry = &ring[pos & (CAPACITY - 1)];
+        size_t seq = entry->sequence.load(memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            dropped.fetch_add(1, memory_order_relaxed); // full
+            return;
+        } else {
+            pos = enqueuePos.load(memory_order_relaxed);
+        }
+    }
+    entry->level = level;
+    entry->time = chrono::system_clock::now();
+    entry->message = move(message);
+    entry->sequence.store(pos + 1, memory_order_release);
+}
+
+bool Logger::drain() {
+    static const char* names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+    string out, err;
+    for (;;) {
+        Entry& entry = ring[dequeuePos & (CAPACITY - 1)];
+        if (entry.sequence.load(memory_order_acquire) != dequeuePos + 1) break;
+
+        time_t seconds = chrono::system_clock::to_time_t(entry.time);
+        if (seconds != stampSecond) {
+            tm local;
+            localtime_r(&seconds, &local);
+            strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+            stampSecond = seconds;
+        }
+
+        string& target = entry.level >= LogLevel::Warn ? err : out;
+        target += stamp;
+        target += ' ';
+        target += names[static_cast<int>(entry.level)];
+        target += ' ';
+        target += entry.message;
+        target += '\n';
+
+        entry.message.clear();
+        entry.sequence.store(dequeuePos + CAPACITY, memory_order_release);
+        dequeuePos++;
+    }
+
+    size_t lost = dropped.exchange(0, memory_order_relaxed);
+    if (lost > 0) {
+        err += "WARN logger dropped " + to_string(lost) + " lines (ring full)\n";
+    }
+    if (!out.empty()) {
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+    if (!err.empty()) {
+        fwrite(err.data(), 1, err.size(), stderr);
+        fflush(stderr);
+    }
+    return !out.empty() || !err.empty();
+}
+
+void Logger::flushLoop() {
+    while (running.load()) {
+        if (!drain()) {
+            this_thread::sleep_for(chrono::milliseconds(2));
+        }
+    }
+    drain();
+}
+
+void Logger::flush() {
+    // Wait for the flusher to catch up with everything enqueued so far
+    size_t target = enqueuePos.load(memory_order_acquire);
+    if (target == 0) return;
+    const Entry& last = ring[(target - 1) & (CAPACITY - 1)];
+    while (running.load() && last.sequence.load(memory_order_acquire) < target - 1 + CAPACITY) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
@@ -0,0 +1,110 @@
+#include "include/PasswordHasher.h"
+#include "include/Logger.h"
+#include <openssl/evp.h>
+#include <openssl/crypto.h>
+#include <future>
+#include <algorithm>
+#include <cstdlib>
+using namespace std;
+
+namespace {
+size_t envCount(const char* name, size_t fallback) {
+    if (const char* env = getenv(name)) {
+        long value = strtol(env, nullptr, 10);
+        if (value > 0) return static_cast<size_t>(value);
+        LOG_WARN("Ignoring invalid " << name << ": " << env);
+    }
+    return fallback;
+}
+
+string toHex(const unsigned char* data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    string out(size * 2, '0');
+    for (size_t i = 0; i < size; i++) {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 15];
+    }
+    return out;
+}
+}
+
+PasswordHasher::PasswordHasher(size_t threads) {
+    if (threads == 0) {
+        size_t cores = max<size_t>(1, thread::hardware_concurrency());
+        threads = envCount("PASSWORD_HASH_THREADS", max<size_t>(1, cores / 4));
+    }
+    iterations = static_cast<uint32_t>(min<size_t>(envCount("PASSWORD_ITERATIONS", DEFAULT_ITERATIONS), UINT32_MAX));
+    // Enough to keep every worker busy with one more waiting behind it
+    maxPending = threads * 2;
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&PasswordHasher::workerLoop, this);
+    }
+    LOG_INFO("Password hashing: " << threads << " threads, " << iterations << " iterations");
+}
+
+PasswordHasher::~PasswordHasher() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void PasswordHasher::workerLoop() {
+    unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (jobs.empty()) break; // stopping, and nothing left to finish
+        function<void()> job = move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+        job();
+        lock.lock();
+        pending--;
+    }
+}
+
+string PasswordHasher::hash(const string& pass, const string& salt, uint32_t rounds) {
+    promise<string> result;
+    future<string> done = result.get_future();
+    {
+        lock_guard<std::mutex> lock(mutex);
+        if (pending >= maxPending) {
+            throw HasherBusyError();
+        }
+        pending++;
+        // The caller waits below, so the references outlive the job
+        jobs.emplace_back([&] {
+            try {
+                result.set_value(derive(pass, salt, rounds));
+            } catch (...) {
+                result.set_exception(current_exception());
+            }
+        });
+    }
+    jobReady.notify_one();
+    return done.get();
+}
+
+string PasswordHasher::derive(const string& pass, const string& salt, uint32_t rounds) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int size = 32;
+    if (rounds == LEGACY) {
+        string input = pass + salt;
+        if (EVP_Digest(input.data(), input.size(), digest, &size, EVP_sha256(), nullptr) != 1) {
+            throw runtime_error("Failed to compute hash");
+        }
+    } else if (PKCS5_PBKDF2_HMAC(pass.data(), static_cast<int>(pass.size()),
+                                 reinterpret_cast<const unsigned char*>(salt.data()), static_cast<int>(salt.size()),
+                                 static_cast<int>(min<uint32_t>(rounds, INT32_MAX)), EVP_sha256(),
+                                 static_cast<int>(size), digest) != 1) {
+        throw runtime_error("Failed to compute hash");
+    }
+    return toHex(digest, size);
+}
+
+bool PasswordHasher::matches(const string& a, const string& b) {
+    return a.size() == b.size() && CRYPTO_memcmp(a.data(), b.data(), a.size()) == 0;
+}
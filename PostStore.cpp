@@ -0,0 +1,103 @@
+#include "include/PostStore.h"
+#include <mutex>
+#include <algorithm>
+using namespace std;
+
+PostStore::PostStore() : published(make_shared<const PostsView>()) {}
+
+PostStore::Chunk& PostStore::writableChunk(size_t chunkIndex) {
+    if (chunkIndex == chunks.size()) {
+        chunks.push_back(make_shared<Chunk>());
+        chunks.back()->reserve(PostsView::CHUNK_SIZE);
+    } else if (chunks[chunkIndex].use_count() > 1) {
+        // A published snapshot still reads this chunk; copy before writing
+        auto copy = make_shared<Chunk>();
+        copy->reserve(PostsView::CHUNK_SIZE);
+        copy->assign(chunks[chunkIndex]->begin(), chunks[chunkIndex]->end());
+        chunks[chunkIndex] = copy;
+    }
+    return *chunks[chunkIndex];
+}
+
+PostPtr PostStore::find(int postId) const {
+    shared_lock<shared_mutex> lock(mutex);
+    auto it = slotById.find(postId);
+    if (it == slotById.end()) return nullptr;
+    return (*chunks[it->second / PostsView::CHUNK_SIZE])[it->second % PostsView::CHUNK_SIZE];
+}
+
+bool PostStore::insert(int postId, PostPtr post) {
+    unique_lock<shared_mutex> lock(mutex);
+    if (slotById.count(postId)) return false;
+    size_t slot = slotCount++;
+    writableChunk(slot / PostsView::CHUNK_SIZE).push_back(move(post));
+    slotById[postId] = slot;
+    return true;
+}
+
+PostPtr PostStore::erase(int postId) {
+    unique_lock<shared_mutex> lock(mutex);
+    auto it = slotById.find(postId);
+    if (it == slotById.end()) return nullptr;
+    size_t slot = it->second;
+    slotById.erase(it);
+    PostPtr removed;
+    writableChunk(slot / PostsView::CHUNK_SIZE)[slot % PostsView::CHUNK_SIZE].swap(removed);
+
+    size_t emptySlots = slotCount - slotById.size();
+    if (emptySlots > PostsView::CHUNK_SIZE && emptySlots > slotById.size()) {
+        compactSlots();
+    }
+    return removed;
+}
+
+void PostStore::compactSlots() {
+    vector<shared_ptr<Chunk>> packed;
+    size_t packedCount = 0;
+    for (const auto& chunk : chunks) {
+        for (const auto& post : *chunk) {
+            if (!post) continue;
+            if (packedCount % PostsView::CHUNK_SIZE == 0) {
+                packed.push_back(make_shared<Chunk>());
+                packed.back()->reserve(PostsView::CHUNK_SIZE);
+            }
+            packed.back()->push_back(post);
+            packedCount++;
+        }
+    }
+
+    // Compaction keeps slot order, so a post's new slot is its rank among the old ones
+    unordered_map<int, size_t> reindexed;
+    reindexed.reserve(slotById.size());
+    vector<pair<size_t, int>> order;
+    order.reserve(slotById.size());
+    for (const auto& entry : slotById) {
+        order.emplace_back(entry.second, entry.first);
+    }
+    sort(order.begin(), order.end());
+    for (size_t i = 0; i < order.size(); i++) {
+        reindexed[order[i].second] = i;
+    }
+
+    chunks.swap(packed);
+    slotById.swap(reindexed);
+    slotCount = packedCount;
+}
+
+void PostStore::clear() {
+    unique_lock<shared_mutex> lock(mutex);
+    chunks.clear();
+    slotById.clear();
+    slotCount = 0;
+}
+
+size_t PostStore::size() const {
+    shared_lock<shared_mutex> lock(mutex);
+    return slotById.size();
+}
+
+void PostStore::publish() {
+    shared_lock<shared_mutex> lock(mutex);
+    vector<shared_ptr<const Chunk>> frozen(chunks.begin(), chunks.end());
+    atomic_store(&published, PostsSnapshot(make_shared<const PostsView>(move(frozen), slotCount, slotById.size())));
+}
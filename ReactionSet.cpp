@@ -0,0 +1,127 @@
+#include "include/ReactionSet.h"
+#include <algorithm>
+using namespace std;
+
+bool ReactionSet::isValidType(string_view type) {
+    static const string_view types[] = {"like", "love", "haha", "wow", "sad", "angry"};
+    return find(begin(types), end(types), type) != end(types);
+}
+
+ReactionSet::ReactionSet(const ReactionSet& other)
+    : small(other.small),
+      large(other.large ? make_unique<unordered_map<SymbolId, SymbolId>>(*other.large) : nullptr),
+      typeCounts(other.typeCounts),
+      total(other.total) {}
+
+ReactionSet& ReactionSet::operator=(const ReactionSet& other) {
+    if (this != &other) {
+        ReactionSet copy(other);
+        *this = move(copy);
+    }
+    return *this;
+}
+
+vector<ReactionSet::Entry>::iterator ReactionSet::findSmall(SymbolId user) {
+    return lower_bound(small.begin(), small.end(), user,
+        [](const Entry& entry, SymbolId id) { return entry.user < id; });
+}
+
+vector<ReactionSet::Entry>::const_iterator ReactionSet::findSmall(SymbolId user) const {
+    return lower_bound(small.begin(), small.end(), user,
+        [](const Entry& entry, SymbolId id) { return entry.user < id; });
+}
+
+void ReactionSet::countType(Symbol type, int delta) {
+    for (auto it = typeCounts.begin(); it != typeCounts.end(); ++it) {
+        if (it->first == type) {
+            it->second += delta;
+            if (it->second == 0) typeCounts.erase(it);
+            return;
+        }
+    }
+    if (delta > 0) typeCounts.emplace_back(type, static_cast<uint32_t>(delta));
+}
+
+void ReactionSet::promote() {
+    large = make_unique<unordered_map<SymbolId, SymbolId>>();
+    large->reserve(small.size() * 2);
+    for (const Entry& entry : small) {
+        large->emplace(entry.user, entry.type);
+    }
+    small.clear();
+    small.shrink_to_fit();
+}
+
+bool ReactionSet::set(Symbol user, Symbol type) {
+    if (large) {
+        auto result = large->emplace(user.id(), type.id());
+        if (!result.second) {
+            if (result.first->second == type.id()) return false;
+            countType(Symbol::fromId(result.first->second), -1);
+            result.first->second = type.id();
+            countType(type, 1);
+            return true;
+        }
+    } else {
+        auto it = findSmall(user.id());
+        if (it != small.end() && it->user == user.id()) {
+            if (it->type == type.id()) return false;
+            countType(Symbol::fromId(it->type), -1);
+            it->type = type.id();
+            countType(type, 1);
+            return true;
+        }
+        small.insert(it, Entry{user.id(), type.id()});
+        if (small.size() > INLINE_LIMIT) promote();
+    }
+    total++;
+    countType(type, 1);
+    return true;
+}
+
+bool ReactionSet::erase(Symbol user) {
+    SymbolId type;
+    if (large) {
+        auto it = large->find(user.id());
+        if (it == large->end()) return false;
+        type = it->second;
+        large->erase(it);
+    } else {
+        auto it = findSmall(user.id());
+        if (it == small.end() || it->user != user.id()) return false;
+        type = it->type;
+        small.erase(it);
+    }
+    total--;
+    countType(Symbol::fromId(type), -1);
+    return true;
+}
+
+bool ReactionSet::toggle(Symbol user, Symbol type) {
+    if (typeOf(user) == type) {
+        erase(user);
+        return false;
+    }
+    set(user, type);
+    return true;
+}
+
+bool ReactionSet::contains(Symbol user) const {
+    return !typeOf(user).empty();
+}
+
+Symbol ReactionSet::typeOf(Symbol user) const {
+    if (large) {
+        auto it = large->find(user.id());
+        return it == large->end() ? Symbol() : Symbol::fromId(it->second);
+    }
+    auto it = findSmall(user.id());
+    return it == small.end() || it->user != user.id() ? Symbol() : Symbol::fromId(it->type);
+}
+
+size_t ReactionSet::count(Symbol type) const {
+    for (const auto& typeCount : typeCounts) {
+        if (typeCount.first == type) return typeCount.second;
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "include/SecureRandom.h"
+#include <openssl/rand.h>
+#include <openssl/crypto.h>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+namespace {
+const char BASE64URL[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+struct Pool {
+    unsigned char bytes[SecureRandom::BUFFER_SIZE];
+    size_t used = SecureRandom::BUFFER_SIZE; // empty until first use
+
+    ~Pool() { OPENSSL_cleanse(bytes, sizeof(bytes)); }
+
+    void refill() {
+        if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+            throw runtime_error("Failed to read from the system CSPRNG");
+        }
+        used = 0;
+    }
+};
+
+thread_local Pool pool;
+}
+
+void SecureRandom::fill(void* out, size_t size) {
+    unsigned char* dest = static_cast<unsigned char*>(out);
+    while (size > 0) {
+        if (pool.used == BUFFER_SIZE) pool.refill();
+        size_t take = min(size, BUFFER_SIZE - pool.used);
+        memcpy(dest, pool.bytes + pool.used, take);
+        // Handed-out bytes are wiped so a later memory leak can't replay them
+        OPENSSL_cleanse(pool.bytes + pool.used, take);
+        pool.used += take;
+        dest += take;
+        size -= take;
+    }
+}
+
+uint64_t SecureRandom::u64() {
+    uint64_t value;
+    fill(&value, sizeof(value));
+    return value;
+}
+
+void SecureRandom::token(char* out, size_t length) {
+    unsigned char chunk[96]; // 128 characters' worth
+    while (length > 0) {
+        size_t chars = min<size_t>(length, 128);
+        size_t bytes = (chars * 3 + 3) / 4;
+        fill(chunk, bytes);
+        for (size_t i = 0, b = 0; i < chars; i += 4, b += 3) {
+            uint32_t n = (uint32_t(chunk[b]) << 16) |
+                         (b + 1 < bytes ? uint32_t(chunk[b + 1]) << 8 : 0) |
+                         (b + 2 < bytes ? chunk[b + 2] : 0);
+            size_t run = min<size_t>(4, chars - i);
+            for (size_t k = 0; k < run; k++) {
+                out[i + k] = BASE64URL[(n >> (18 - 6 * k)) & 63];
+            }
+        }
+        OPENSSL_cleanse(chunk, bytes);
+        out += chars;
+        length -= chars;
+    }
+}
+
+string SecureRandom::token(size_t length) {
+    string out(length, '\0');
+    token(out.data(), length);
+    return out;
+}
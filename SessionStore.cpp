@@ -0,0 +1,313 @@
+#include "include/SessionStore.h"
+#include "include/Logger.h"
+#include "include/Snapshot.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <cstdlib>
+using namespace std;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+SessionStore::SessionStore(const string& file)
+    : tokenShards(new TokenShard[SHARDS]), userShards(new UserShard[SHARDS]),
+      ttl(7 * 24 * 3600), wheel(WHEEL_SLOTS), path(file), journal(file + ".wal") {
+    if (const char* env = getenv("SESSION_TTL")) {
+        long seconds = strtol(env, nullptr, 10);
+        if (seconds > 0) {
+            ttl = seconds;
+        } else {
+            LOG_WARN("Ignoring invalid SESSION_TTL: " << env);
+        }
+    }
+    wheelTick = time(nullptr) / WHEEL_TICK;
+}
+
+SessionStore::~SessionStore() {
+    {
+        lock_guard<mutex> lock(workerMutex);
+        stopWorker = true;
+    }
+    workerCv.notify_one();
+    if (worker.joinable()) worker.join();
+    try {
+        flush();
+    } catch (const exception& e) {
+        LOG_ERROR("Error flushing sessions: " << e.what());
+    }
+}
+
+SessionStore::TokenShard& SessionStore::tokenShard(const string& token) const {
+    return tokenShards[hash<string>()(token) & (SHARDS - 1)];
+}
+
+SessionStore::UserShard& SessionStore::userShard(Symbol user) const {
+    return userShards[user.id() & (SHARDS - 1)];
+}
+
+void SessionStore::insert(const string& token, Symbol user, time_t expires) {
+    {
+        TokenShard& shard = tokenShard(token);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        shard.sessions.insert_or_assign(token, Session{user, expires});
+    }
+    schedule(token, expires);
+}
+
+bool SessionStore::erase(const string& token, Symbol& user) {
+    {
+        TokenShard& shard = tokenShard(token);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(token);
+        if (it == shard.sessions.end()) return false;
+        user = it->second.user;
+        shard.sessions.erase(it);
+    }
+    // The user may have logged in again since; only drop this token
+    UserShard& owner = userShard(user);
+    lock_guard<mutex> lock(owner.mutex);
+    auto it = owner.tokens.find(user);
+    if (it != owner.tokens.end() && it->second == token) {
+        owner.tokens.erase(it);
+    }
+    return true;
+}
+
+void SessionStore::schedule(const string& token, time_t expires) {
+    lock_guard<mutex> lock(wheelMutex);
+    // Never behind the sweep, or the session would wait a whole turn
+    time_t tick = max(expires / WHEEL_TICK, wheelTick + 1);
+    wheel[static_cast<size_t>(tick) % WHEEL_SLOTS].push_back(token);
+}
+
+void SessionStore::queue(json record) {
+    lock_guard<mutex> lock(pendingMutex);
+    pending.push_back(move(record));
+}
+
+string SessionStore::open(Symbol user, const function<string()>& newToken) {
+    time_t now = time(nullptr);
+    UserShard& owner = userShard(user);
+    lock_guard<mutex> ownerLock(owner.mutex);
+
+    auto existing = owner.tokens.find(user);
+    if (existing != owner.tokens.end()) {
+        TokenShard& shard = tokenShard(existing->second);
+        shared_lock<shared_mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(existing->second);
+        if (it != shard.sessions.end() && it->second.expires > now) {
+            return existing->second;
+        }
+    }
+
+    string token;
+    time_t expires = now + ttl;
+    for (;;) {
+        token = newToken();
+        TokenShard& shard = tokenShard(token);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        if (shard.sessions.emplace(token, Session{user, expires}).second) break;
+    }
+    owner.tokens[user] = token;
+    schedule(token, expires);
+    queue({{"op", "open"}, {"token", token}, {"user", user.str()}, {"expires", expires}});
+    return token;
+}
+
+bool SessionStore::close(const string& token) {
+    Symbol user;
+    if (!erase(token, user)) return false;
+    queue({{"op", "close"}, {"token", token}});
+    flush();
+    return true;
+}
+
+bool SessionStore::find(const string& token, Symbol& user) const {
+    TokenShard& shard = tokenShard(token);
+    shared_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(token);
+    if (it == shard.sessions.end() || it->second.expires <= time(nullptr)) return false;
+    user = it->second.user;
+    return true;
+}
+
+bool SessionStore::contains(const string& token) const {
+    Symbol user;
+    return find(token, user);
+}
+
+size_t SessionStore::size() const {
+    size_t count = 0;
+    for (size_t i = 0; i < SHARDS; i++) {
+        shared_lock<shared_mutex> lock(tokenShards[i].mutex);
+        count += tokenShards[i].sessions.size();
+    }
+    return count;
+}
+
+// Expired sessions are not journaled: replay drops them by their expiry
+void SessionStore::sweep(time_t now) {
+    vector<string> due;
+    {
+        lock_guard<mutex> lock(wheelMutex);
+        time_t current = now / WHEEL_TICK;
+        // After a long stall one full turn visits every slot
+        time_t first = max(wheelTick + 1, current - static_cast<time_t>(WHEEL_SLOTS) + 1);
+        for (time_t tick = first; tick <= current; tick++) {
+            auto& slot = wheel[static_cast<size_t>(tick) % WHEEL_SLOTS];
+            due.insert(due.end(), make_move_iterator(slot.begin()), make_move_iterator(slot.end()));
+            slot.clear();
+        }
+        wheelTick = max(wheelTick, current);
+    }
+    if (due.empty()) return;
+
+    size_t evicted = 0;
+    for (const string& token : due) {
+        time_t expires = 0;
+        {
+            TokenShard& shard = tokenShard(token);
+            shared_lock<shared_mutex> lock(shard.mutex);
+            auto it = shard.sessions.find(token);
+            if (it == shard.sessions.end()) continue; // logged out already
+            expires = it->second.expires;
+        }
+        if (expires > now) {
+            schedule(token, expires); // due on a later turn of the wheel
+            continue;
+        }
+        Symbol user;
+        if (erase(token, user)) evicted++;
+    }
+    if (evicted > 0) {
+        LOG_DEBUG("Evicted " << evicted << " expired sessions");
+    }
+}
+
+void SessionStore::workerLoop() {
+    unique_lock<mutex> lock(workerMutex);
+    while (!stopWorker) {
+        workerCv.wait_for(lock, flushInterval, [this] { return stopWorker; });
+        if (stopWorker) break;
+
+        lock.unlock();
+        try {
+            sweep(time(nullptr));
+            flush();
+            if (journal.size() >= compactThreshold) compact();
+        } catch (const exception& e) {
+            LOG_ERROR("Error persisting sessions: " << e.what());
+        }
+        lock.lock();
+    }
+}
+
+void SessionStore::flush() {
+    // Logins keep queueing while the batch is written; only other flushes wait
+    lock_guard<mutex> flushLock(flushMutex);
+    vector<json> batch;
+    {
+        lock_guard<mutex> lock(pendingMutex);
+        batch.swap(pending);
+    }
+    journal.appendBatch(batch);
+}
+
+void SessionStore::compact() {
+    lock_guard<mutex> compactLock(compactMutex);
+
+    // Everything queued so far goes to the log being rotated out; changes
+    // queued after that land in the new log and replay idempotently
+    {
+        lock_guard<mutex> flushLock(flushMutex);
+        lock_guard<mutex> lock(pendingMutex);
+        journal.appendBatch(pending);
+        pending.clear();
+        journal.rotate();
+    }
+
+    time_t now = time(nullptr);
+    json sessions_json = json::array();
+    for (size_t i = 0; i < SHARDS; i++) {
+        shared_lock<shared_mutex> lock(tokenShards[i].mutex);
+        for (const auto& session : tokenShards[i].sessions) {
+            if (session.second.expires <= now) continue;
+            sessions_json.push_back({
+                {"token", session.first},
+                {"username", session.second.user.str()},
+                {"expires", session.second.expires}
+            });
+        }
+    }
+    json final_json;
+    final_json["sessions"] = sessions_json;
+
+    // Written next to the old snapshot, synced and swapped in before the
+    // rotated journal is dropped
+    snapshot::replaceFile(path, {final_json.dump()});
+    journal.dropRotated();
+    LOG_DEBUG("Saved " << sessions_json.size() << " sessions");
+}
+
+void SessionStore::loadSnapshot() {
+    ifstream file(path);
+    if (!file.is_open()) {
+        LOG_INFO("No existing sessions file found, starting with empty sessions");
+        return; // File might not exist on first run
+    }
+    // Check if the file is empty before parsing
+    file.seekg(0, ios::end);
+    if (file.tellg() == 0) {
+        LOG_INFO("Sessions file is empty");
+        return;
+    }
+    file.seekg(0, ios::beg);
+
+    try {
+        json data;
+        file >> data;
+        if (!data.contains("sessions")) return;
+        time_t now = time(nullptr);
+        for (const auto& session : data["sessions"]) {
+            // Sessions saved before expiry was tracked get a fresh lifetime
+            time_t expires = session.value("expires", static_cast<time_t>(now + ttl));
+            if (expires <= now) continue;
+            Symbol user(session["username"].get<string>());
+            string token = session["token"];
+            insert(token, user, expires);
+            userShard(user).tokens[user] = token;
+        }
+    } catch (const exception& e) {
+        LOG_ERROR("Error loading sessions: " << e.what());
+    }
+}
+
+// Replay must be idempotent: after a crash mid-compaction the rotated log
+// is replayed on top of a snapshot that already contains its effects
+void SessionStore::applyRecord(const json& record, time_t now) {
+    const string op = record.value("op", "");
+    const string token = record.value("token", "");
+    if (op == "open") {
+        time_t expires = record.value("expires", static_cast<time_t>(0));
+        if (expires <= now) return;
+        Symbol user(record.at("user").get<string>());
+        insert(token, user, expires);
+        userShard(user).tokens[user] = token;
+    } else if (op == "close") {
+        Symbol user;
+        erase(token, user);
+    } else {
+        LOG_WARN("Unknown session record: " << op);
+    }
+}
+
+void SessionStore::load() {
+    loadSnapshot();
+    time_t now = time(nullptr);
+    size_t replayed = journal.replay([this, now](const json& record) { applyRecord(record, now); });
+    if (replayed > 0) {
+        LOG_INFO("Replayed " << replayed << " session journal records");
+    }
+    LOG_INFO("Loaded " << size() << " sessions");
+    worker = thread(&SessionStore::workerLoop, this);
+}
@@ -0,0 +1,374 @@
+#include "include/SignedTokens.h"
+#include "include/Logger.h"
+#include "include/SecureRandom.h"
+#include "include/Snapshot.h"
+#include <openssl/hmac.h>
+#include <openssl/evp.h>
+#include <openssl/crypto.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+const char BASE64URL[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+void putU64(string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+uint64_t getU64(string_view in, size_t pos) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= uint64_t(static_cast<unsigned char>(in[pos + i])) << (8 * i);
+    return value;
+}
+}
+
+string SignedTokens::base64url(const unsigned char* data, size_t size) {
+    string out;
+    out.reserve((size * 4 + 2) / 3);
+    size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        uint32_t n = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+        out += BASE64URL[(n >> 18) & 63];
+        out += BASE64URL[(n >> 12) & 63];
+        out += BASE64URL[(n >> 6) & 63];
+        out += BASE64URL[n & 63];
+    }
+    if (size - i == 1) {
+        uint32_t n = uint32_t(data[i]) << 16;
+        out += BASE64URL[(n >> 18) & 63];
+        out += BASE64URL[(n >> 12) & 63];
+    } else if (size - i == 2) {
+        uint32_t n = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8);
+        out += BASE64URL[(n >> 18) & 63];
+        out += BASE64URL[(n >> 12) & 63];
+        out += BASE64URL[(n >> 6) & 63];
+    }
+    return out;
+}
+
+bool SignedTokens::unbase64url(string_view text, string& out) {
+    if (text.size() % 4 == 1) return false;
+    out.clear();
+    out.reserve(text.size() * 3 / 4);
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : text) {
+        int v;
+        if (c >= 'A' && c <= 'Z') v = c - 'A';
+        else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') v = c - '0' + 52;
+        else if (c == '-') v = 62;
+        else if (c == '_') v = 63;
+        else return false;
+        bits = (bits << 6) | static_cast<uint32_t>(v);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out += static_cast<char>((bits >> count) & 0xff);
+        }
+    }
+    return true;
+}
+
+SignedTokens::SignedTokens(const string& keyPath, const string& revokedFile, chrono::seconds lifetime)
+    : ttl(lifetime.count()), revokedPath(revokedFile) {
+    loadKey(keyPath);
+
+    fs::path p(revokedPath);
+    if (p.has_parent_path()) {
+        fs::create_directories(p.parent_path());
+    }
+    // O_APPEND keeps each revocation line whole when several processes write
+    revokedFd = ::open(revokedPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (revokedFd < 0) {
+        throw runtime_error("Failed to open revocation list: " + revokedPath);
+    }
+    readRevocations();
+    LOG_INFO("Signed session tokens enabled (" << revokedCount.load() << " revoked)");
+    worker = thread(&SignedTokens::workerLoop, this);
+}
+
+SignedTokens::~SignedTokens() {
+    {
+        lock_guard<mutex> lock(workerMutex);
+        stopWorker = true;
+    }
+    workerCv.notify_one();
+    if (worker.joinable()) worker.join();
+    if (revokedFd >= 0) ::close(revokedFd);
+    OPENSSL_cleanse(key, sizeof(key));
+}
+
+void SignedTokens::loadKey(const string& keyPath) {
+    if (const char* secret = getenv("SESSION_SECRET")) {
+        if (strlen(secret) < 16) {
+            throw runtime_error("SESSION_SECRET must be at least 16 characters");
+        }
+        // Stretch whatever was given into a fixed-size key
+        unsigned int size = 0;
+        if (EVP_Digest(secret, strlen(secret), key, &size, EVP_sha256(), nullptr) != 1) {
+            throw runtime_error("Failed to derive the session key");
+        }
+        return;
+    }
+
+    if (!fs::exists(keyPath)) {
+        unsigned char fresh[KEY_SIZE];
+        SecureRandom::fill(fresh, sizeof(fresh));
+        // Write a private file, then link it into place: link() fails if
+        // another process got there first, and then we use its key
+        string tmp = keyPath + "." + to_string(getpid()) + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) {
+            throw runtime_error("Failed to create session key file: " + tmp);
+        }
+        bool written = ::write(fd, fresh, sizeof(fresh)) == static_cast<ssize_t>(sizeof(fresh)) && ::fsync(fd) == 0;
+        ::close(fd);
+        OPENSSL_cleanse(fresh, sizeof(fresh));
+        if (written && ::link(tmp.c_str(), keyPath.c_str()) == 0) {
+            LOG_INFO("Created session key " << keyPath);
+        }
+        ::unlink(tmp.c_str());
+    }
+
+    ifstream in(keyPath, ios::binary);
+    in.read(reinterpret_cast<char*>(key), sizeof(key));
+    if (in.gcount() != static_cast<streamsize>(sizeof(key))) {
+        throw runtime_error("Session key file is unreadable or too short: " + keyPath);
+    }
+}
+
+void SignedTokens::sign(string_view payload, unsigned char* out) const {
+    unsigned int size = 0;
+    if (!HMAC(EVP_sha256(), key, sizeof(key), reinterpret_cast<const unsigned char*>(payload.data()),
+              payload.size(), out, &size) || size != SIGNATURE_SIZE) {
+        throw runtime_error("Failed to sign session token");
+    }
+}
+
+// Payload: version, issued (u64), expires (u64), id (u64), username; little-endian
+string SignedTokens::issue(const string& user) const {
+    uint64_t id = SecureRandom::u64();
+    time_t now = time(nullptr);
+    string payload;
+    payload.reserve(25 + user.size());
+    payload += static_cast<char>(VERSION);
+    putU64(payload, static_cast<uint64_t>(now));
+    putU64(payload, static_cast<uint64_t>(now + ttl));
+    putU64(payload, id);
+    payload += user;
+
+    unsigned char signature[SIGNATURE_SIZE];
+    sign(payload, signature);
+    return base64url(reinterpret_cast<const unsigned char*>(payload.data()), payload.size()) + "." +
+           base64url(signature, sizeof(signature));
+}
+
+bool SignedTokens::decode(string_view token, string& user, uint64_t& id, time_t& expires) const {
+    size_t dot = token.find('.');
+    if (dot == string_view::npos) return false;
+    string payload, signature;
+    if (!unbase64url(token.substr(0, dot), payload) || !unbase64url(token.substr(dot + 1), signature)) {
+        return false;
+    }
+    if (signature.size() != SIGNATURE_SIZE || payload.size() <= 25 || payload[0] != static_cast<char>(VERSION)) {
+        return false;
+    }
+    unsigned char expected[SIGNATURE_SIZE];
+    sign(payload, expected);
+    if (CRYPTO_memcmp(expected, signature.data(), SIGNATURE_SIZE) != 0) return false;
+
+    expires = static_cast<time_t>(getU64(payload, 9));
+    id = getU64(payload, 17);
+    user.assign(payload, 25, string::npos);
+    return true;
+}
+
+bool SignedTokens::verify(string_view token, string& user) const {
+    uint64_t id;
+    time_t expires;
+    string name;
+    if (!decode(token, name, id, expires) || expires <= time(nullptr)) return false;
+    if (revokedCount.load(memory_order_acquire) > 0) {
+        shared_lock<shared_mutex> lock(revokedMutex);
+        if (revoked.count(id)) return false;
+    }
+    user = move(name);
+    return true;
+}
+
+void SignedTokens::addRevoked(uint64_t id, time_t expires) {
+    unique_lock<shared_mutex> lock(revokedMutex);
+    revoked.emplace(id, expires);
+    revokedCount.store(revoked.size(), memory_order_release);
+}
+
+bool SignedTokens::revoke(string_view token) {
+    uint64_t id;
+    time_t expires;
+    string user;
+    if (!decode(token, user, id, expires) || expires <= time(nullptr)) return false;
+    addRevoked(id, expires);
+
+    char line[64];
+    int size = snprintf(line, sizeof(line), "%016llx %lld\n",
+                        static_cast<unsigned long long>(id), static_cast<long long>(expires));
+    if (!appendRevocation(line, static_cast<size_t>(size))) {
+        LOG_ERROR("Failed to record revoked token in " << revokedPath);
+    }
+    return true;
+}
+
+// Caller holds fileMutex. True if revokedFd is (now) the file at revokedPath.
+bool SignedTokens::followReplacedFile() {
+    struct stat opened, current;
+    if (::fstat(revokedFd, &opened) == 0 && ::stat(revokedPath.c_str(), &current) == 0 &&
+        opened.st_dev == current.st_dev && opened.st_ino == current.st_ino) {
+        return true;
+    }
+    int fd = ::open(revokedPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+    ::close(revokedFd);
+    revokedFd = fd;
+    return false;
+}
+
+bool SignedTokens::appendRevocation(const char* line, size_t size) {
+    lock_guard<mutex> lock(fileMutex);
+    // A rewrite may replace the file while we wait for the lock; then the
+    // lock is on the old file and we go again on the new one
+    for (int attempt = 0; attempt < 3; attempt++) {
+        if (::flock(revokedFd, LOCK_SH) != 0) return false;
+        if (followReplacedFile()) {
+            bool written = ::write(revokedFd, line, size) == static_cast<ssize_t>(size);
+            ::flock(revokedFd, LOCK_UN);
+            return written;
+        }
+        // followReplacedFile closed the old descriptor, and its lock with it
+    }
+    return false;
+}
+
+// Rewrite the file with the unexpired revocations only. Runs on the worker.
+void SignedTokens::compactRevocations() {
+    lock_guard<mutex> lock(fileMutex);
+    if (::flock(revokedFd, LOCK_EX) != 0) return;
+    if (!followReplacedFile()) return; // another process just did it
+
+    // Nobody can append now: pick up the last lines, then everything in
+    // 'revoked' is exactly the live part of the file (plus any of our own
+    // revocations whose write failed)
+    readRevocations();
+    time_t now = time(nullptr);
+    string content;
+    size_t lines = 0;
+    {
+        shared_lock<shared_mutex> revokedLock(revokedMutex);
+        content.reserve(revoked.size() * 28);
+        char line[64];
+        for (const auto& entry : revoked) {
+            if (entry.second <= now) continue;
+            int size = snprintf(line, sizeof(line), "%016llx %lld\n",
+                                static_cast<unsigned long long>(entry.first), static_cast<long long>(entry.second));
+            content.append(line, static_cast<size_t>(size));
+            lines++;
+        }
+    }
+    size_t before = linesRead;
+    try {
+        snapshot::replaceFile(revokedPath, {content});
+    } catch (...) {
+        ::flock(revokedFd, LOCK_UN);
+        throw;
+    }
+    // Closing the old descriptor releases the lock; other processes then
+    // find the file replaced and reopen it too
+    followReplacedFile();
+
+    struct stat current;
+    if (::fstat(revokedFd, &current) == 0) {
+        readInode = static_cast<uint64_t>(current.st_ino);
+        readOffset = content.size();
+        linesRead = lines;
+    }
+    LOG_INFO("Compacted revoked tokens: " << before << " lines -> " << lines);
+}
+
+// Lines are "<id as 16 hex digits> <expires>"; a torn last line is left
+// for the next read, when the writer will have finished it
+void SignedTokens::readRevocations() {
+    int fd = ::open(revokedPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return;
+    }
+    uint64_t end = static_cast<uint64_t>(info.st_size);
+    if (static_cast<uint64_t>(info.st_ino) != readInode || end < readOffset) {
+        // The file was rewritten: read the new one from the start
+        readInode = static_cast<uint64_t>(info.st_ino);
+        readOffset = 0;
+        linesRead = 0;
+    }
+    string chunk(end - readOffset, '\0');
+    ssize_t got = chunk.empty() ? 0 : ::pread(fd, chunk.data(), chunk.size(), static_cast<off_t>(readOffset));
+    ::close(fd);
+    if (got <= 0) return;
+    chunk.resize(static_cast<size_t>(got));
+
+    time_t now = time(nullptr);
+    size_t start = 0;
+    for (size_t newline; (newline = chunk.find('\n', start)) != string::npos; start = newline + 1) {
+        linesRead++;
+        unsigned long long id;
+        long long expires;
+        string line = chunk.substr(start, newline - start);
+        if (sscanf(line.c_str(), "%llx %lld", &id, &expires) != 2) {
+            LOG_WARN("Ignoring malformed revocation: " << line);
+            continue;
+        }
+        if (expires > now) addRevoked(id, static_cast<time_t>(expires));
+    }
+    readOffset += start;
+}
+
+void SignedTokens::workerLoop() {
+    unique_lock<mutex> lock(workerMutex);
+    while (!stopWorker) {
+        workerCv.wait_for(lock, refreshInterval, [this] { return stopWorker; });
+        if (stopWorker) break;
+
+        lock.unlock();
+        try {
+            readRevocations();
+            // Expired tokens fail on their own; forget their revocations
+            time_t now = time(nullptr);
+            {
+                unique_lock<shared_mutex> revokedLock(revokedMutex);
+                for (auto it = revoked.begin(); it != revoked.end();) {
+                    it = it->second <= now ? revoked.erase(it) : next(it);
+                }
+                revokedCount.store(revoked.size(), memory_order_release);
+            }
+            // Mostly expired lines: rewrite the file so it (and every
+            // process's startup read) stays proportional to live logouts
+            if (linesRead >= MIN_COMPACT_LINES && linesRead > 2 * revokedCount.load()) {
+                compactRevocations();
+            }
+        } catch (const exception& e) {
+            LOG_ERROR("Error refreshing revoked tokens: " << e.what());
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,207 @@
+#include "include/Snapshot.h"
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <array>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+const char MAGIC[8] = {'C', 'S', '2', 'S', 'N', 'A', 'P', '\0'};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint64_t payloadSize;
+    uint32_t crc;
+    uint32_t reserved;
+};
+static_assert(sizeof(Header) == 32, "snapshot header must stay 32 bytes");
+
+array<uint32_t, 256> makeCrcTable() {
+    array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int bit = 0; bit < 8; bit++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+}
+
+uint32_t snapshot::crc32(const char* data, size_t size, uint32_t crc) {
+    static const array<uint32_t, 256> table = makeCrcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void snapshot::replaceFile(const string& path, initializer_list<string_view> parts) {
+    fs::path filePath(path);
+    if (filePath.has_parent_path()) {
+        fs::create_directories(filePath.parent_path());
+    }
+    string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw runtime_error("Failed to open snapshot for writing: " + tmpPath);
+    }
+    bool written = true;
+    for (string_view part : parts) {
+        while (written && !part.empty()) {
+            ssize_t n = ::write(fd, part.data(), part.size());
+            if (n < 0 && errno == EINTR) continue;
+            written = n > 0;
+            if (written) part.remove_prefix(static_cast<size_t>(n));
+        }
+    }
+    // Without this the rename can reach the disk before the data does,
+    // and a crash leaves an empty or torn file under the real name
+    written = written && ::fsync(fd) == 0;
+    written = ::close(fd) == 0 && written;
+    if (!written) {
+        ::unlink(tmpPath.c_str());
+        throw runtime_error("Failed to write snapshot: " + tmpPath);
+    }
+    fs::rename(tmpPath, filePath);
+
+    // The rename is only durable once the directory entry is
+    string dir = filePath.has_parent_path() ? filePath.parent_path().string() : ".";
+    int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    bool synced = dirFd >= 0 && ::fsync(dirFd) == 0;
+    if (dirFd >= 0) ::close(dirFd);
+    if (!synced) {
+        throw runtime_error("Failed to sync snapshot directory: " + dir);
+    }
+}
+
+string snapshot::binaryPath(const string& jsonPath) {
+    return fs::path(jsonPath).replace_extension(".bin").string();
+}
+
+//------------------------------------------------------------
+// SnapshotWriter
+//------------------------------------------------------------
+void SnapshotWriter::str(string_view text) {
+    u32(static_cast<uint32_t>(text.size()));
+    raw(text.data(), text.size());
+}
+
+void SnapshotWriter::symbol(Symbol name) {
+    auto result = symbolIndex.emplace(name.id(), static_cast<uint32_t>(symbols.size()));
+    if (result.second) {
+        symbols.push_back(name.id());
+    }
+    u32(result.first->second);
+}
+
+void SnapshotWriter::save(const string& path, uint32_t kind) const {
+    // The symbol table goes first so the reader can resolve indexes as it goes
+    SnapshotWriter table;
+    table.u32(static_cast<uint32_t>(symbols.size()));
+    for (SymbolId id : symbols) {
+        table.str(SymbolTable::global().name(id));
+    }
+
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = snapshot::VERSION;
+    header.kind = kind;
+    header.payloadSize = table.payload.size() + payload.size();
+    header.crc = snapshot::crc32(table.payload.data(), table.payload.size());
+    header.crc = snapshot::crc32(payload.data(), payload.size(), header.crc);
+
+    snapshot::replaceFile(path, {
+        string_view(reinterpret_cast<const char*>(&header), sizeof(header)),
+        table.payload,
+        payload,
+    });
+}
+
+//------------------------------------------------------------
+// SnapshotReader
+//------------------------------------------------------------
+SnapshotReader::SnapshotReader(const string& path, uint32_t kind) : path_(path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Cannot open snapshot: " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        ::close(fd);
+        throw runtime_error("Snapshot is truncated: " + path);
+    }
+    mappedSize = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw runtime_error("Cannot map snapshot: " + path);
+    }
+    base = static_cast<const char*>(mapping);
+    madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+
+    try {
+        Header header;
+        memcpy(&header, base, sizeof(header));
+        if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw runtime_error("Not a snapshot file: " + path);
+        }
+        if (header.version < snapshot::MIN_VERSION || header.version > snapshot::VERSION || header.kind != kind) {
+            throw runtime_error("Unsupported snapshot version or kind: " + path);
+        }
+        if (header.payloadSize != mappedSize - sizeof(Header)) {
+            throw runtime_error("Snapshot is truncated: " + path);
+        }
+        version_ = header.version;
+        pos = base + sizeof(Header);
+        end = pos + header.payloadSize;
+        if (snapshot::crc32(pos, header.payloadSize) != header.crc) {
+            throw runtime_error("Snapshot checksum mismatch: " + path);
+        }
+
+        uint32_t count = u32();
+        symbols.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            symbols.push_back(Symbol(str()));
+        }
+    } catch (...) {
+        munmap(const_cast<char*>(base), mappedSize);
+        throw;
+    }
+}
+
+SnapshotReader::~SnapshotReader() {
+    munmap(const_cast<char*>(base), mappedSize);
+}
+
+const char* SnapshotReader::take(size_t size) {
+    if (static_cast<size_t>(end - pos) < size) {
+        throw runtime_error("Snapshot ended early: " + path_);
+    }
+    const char* data = pos;
+    pos += size;
+    return data;
+}
+
+string_view SnapshotReader::str() {
+    uint32_t size = u32();
+    return string_view(take(size), size);
+}
+
+Symbol SnapshotReader::symbol() {
+    uint32_t index = u32();
+    if (index >= symbols.size()) {
+        throw runtime_error("Bad symbol index in snapshot: " + path_);
+    }
+    return symbols[index];
+}
@@ -0,0 +1,58 @@
+#include "include/SymbolTable.h"
+#include <mutex>
+#include <stdexcept>
+using namespace std;
+
+SymbolTable::SymbolTable() : blocks(new atomic<string*>[MAX_BLOCKS]) {
+    for (size_t i = 0; i < MAX_BLOCKS; i++) {
+        blocks[i].store(nullptr, memory_order_relaxed);
+    }
+    intern(""); // id 0
+}
+
+SymbolTable::~SymbolTable() {
+    for (size_t i = 0; i < MAX_BLOCKS; i++) {
+        delete[] blocks[i].load(memory_order_relaxed);
+    }
+}
+
+SymbolTable& SymbolTable::global() {
+    static SymbolTable table;
+    return table;
+}
+
+bool SymbolTable::find(string_view text, SymbolId& id) const {
+    shared_lock<shared_mutex> lock(mutex);
+    auto it = ids.find(text);
+    if (it == ids.end()) return false;
+    id = it->second;
+    return true;
+}
+
+SymbolId SymbolTable::intern(string_view text) {
+    {
+        shared_lock<shared_mutex> lock(mutex);
+        auto it = ids.find(text);
+        if (it != ids.end()) return it->second;
+    }
+
+    unique_lock<shared_mutex> lock(mutex);
+    auto it = ids.find(text);
+    if (it != ids.end()) return it->second;
+
+    size_t id = count.load(memory_order_relaxed);
+    size_t block = id >> BLOCK_BITS;
+    if (block >= MAX_BLOCKS) {
+        throw runtime_error("Symbol table is full");
+    }
+    string* names = blocks[block].load(memory_order_relaxed);
+    if (!names) {
+        names = new string[BLOCK_SIZE];
+        blocks[block].store(names, memory_order_release);
+    }
+    string& slot = names[id & (BLOCK_SIZE - 1)];
+    slot.assign(text.data(), text.size());
+    ids.emplace(string_view(slot), static_cast<SymbolId>(id));
+    count.store(id + 1, memory_order_release);
+    return static_cast<SymbolId>(id);
+}
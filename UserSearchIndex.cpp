@@ -0,0 +1,227 @@
+#include "include/UserSearchIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <mutex>
+#include <unordered_set>
+using namespace std;
+
+string UserSearchIndex::fold(const string& text) {
+    string result(text);
+    for (auto& c : result) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+static uint32_t trigramAt(const string& text, size_t pos) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+}
+
+void UserSearchIndex::indexTrigrams(uint32_t id) {
+    const string& name = folded[id];
+    for (size_t pos = 0; pos + 3 <= name.size(); pos++) {
+        auto& postings = trigrams[trigramAt(name, pos)];
+        // Ids only grow, so a repeated trigram in the same name is always the last entry
+        if (postings.empty() || postings.back() != id) postings.push_back(id);
+    }
+}
+
+vector<uint32_t> UserSearchIndex::substringCandidates(const string& key) const {
+    vector<uint32_t> candidates;
+    if (key.size() < 3) {
+        candidates.reserve(folded.size());
+        for (uint32_t id = 0; id < folded.size(); id++) candidates.push_back(id);
+        return candidates;
+    }
+
+    vector<const vector<uint32_t>*> lists;
+    for (size_t pos = 0; pos + 3 <= key.size(); pos++) {
+        auto it = trigrams.find(trigramAt(key, pos));
+        if (it == trigrams.end()) return candidates; // some trigram never occurs
+        lists.push_back(&it->second);
+    }
+    sort(lists.begin(), lists.end(), [](const vector<uint32_t>* a, const vector<uint32_t>* b) {
+        return a->size() != b->size() ? a->size() < b->size() : a < b;
+    });
+    lists.erase(unique(lists.begin(), lists.end()), lists.end());
+
+    // Start from the rarest trigram and binary search the others
+    candidates = *lists[0];
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+        const auto& postings = *lists[i];
+        auto from = postings.begin();
+        size_t kept = 0;
+        for (uint32_t id : candidates) {
+            from = lower_bound(from, postings.end(), id);
+            if (from == postings.end()) break;
+            if (*from == id) candidates[kept++] = id;
+        }
+        candidates.resize(kept);
+    }
+    return candidates;
+}
+
+bool UserSearchIndex::containsLocked(const string& foldedName) const {
+    auto less = [this](uint32_t id, const string& key) { return folded[id] < key; };
+    for (const auto* run : {&sorted, &pending}) {
+        auto it = lower_bound(run->begin(), run->end(), foldedName, less);
+        if (it != run->end() && folded[*it] == foldedName) return true;
+    }
+    return false;
+}
+
+void UserSearchIndex::mergePending() {
+    auto byName = [this](uint32_t a, uint32_t b) { return folded[a] < folded[b]; };
+    vector<uint32_t> merged;
+    merged.reserve(sorted.size() + pending.size());
+    merge(sorted.begin(), sorted.end(), pending.begin(), pending.end(), back_inserter(merged), byName);
+    sorted.swap(merged);
+    pending.clear();
+}
+
+void UserSearchIndex::insertUser(const string& username) {
+    if (username.empty()) {
+        throw invalid_argument("Cannot insert empty username");
+    }
+    string key = fold(username);
+    unique_lock<shared_mutex> lock(mutex);
+    if (containsLocked(key)) return;
+
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(Symbol(username));
+    folded.push_back(move(key));
+    indexTrigrams(id);
+    auto it = upper_bound(pending.begin(), pending.end(), id,
+        [this](uint32_t a, uint32_t b) { return folded[a] < folded[b]; });
+    pending.insert(it, id);
+    if (pending.size() > PENDING_LIMIT) {
+        mergePending();
+    }
+}
+
+void UserSearchIndex::rebuildFromUsers(const vector<string>& users) {
+    unique_lock<shared_mutex> lock(mutex);
+    names.clear();
+    folded.clear();
+    sorted.clear();
+    pending.clear();
+    trigrams.clear();
+    names.reserve(users.size());
+    folded.reserve(users.size());
+
+    // Keep the first spelling of names that only differ by case
+    unordered_set<string> seen;
+    for (const auto& user : users) {
+        if (user.empty()) continue;
+        string key = fold(user);
+        if (!seen.insert(key).second) continue;
+        names.push_back(Symbol(user));
+        folded.push_back(move(key));
+    }
+    vector<uint32_t> order(names.size());
+    for (uint32_t id = 0; id < order.size(); id++) order[id] = id;
+    sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return folded[a] < folded[b]; });
+    sorted.swap(order);
+    for (uint32_t id = 0; id < folded.size(); id++) {
+        indexTrigrams(id);
+    }
+}
+
+void UserSearchIndex::clear() {
+    unique_lock<shared_mutex> lock(mutex);
+    names.clear();
+    folded.clear();
+    sorted.clear();
+    pending.clear();
+    trigrams.clear();
+}
+
+vector<string> UserSearchIndex::searchByPrefix(const string& prefix, size_t limit) const {
+    vector<string> result;
+    if (prefix.empty() || limit == 0) return result;
+    string key = fold(prefix);
+
+    shared_lock<shared_mutex> lock(mutex);
+    auto less = [this](uint32_t id, const string& k) { return folded[id] < k; };
+    auto matches = [this, &key](uint32_t id) { return folded[id].compare(0, key.size(), key) == 0; };
+    auto a = lower_bound(sorted.begin(), sorted.end(), key, less);
+    auto b = lower_bound(pending.begin(), pending.end(), key, less);
+
+    // Both runs are ordered, so merge the two ranges of matches
+    while (result.size() < limit) {
+        bool moreA = a != sorted.end() && matches(*a);
+        bool moreB = b != pending.end() && matches(*b);
+        if (!moreA && !moreB) break;
+        if (moreA && (!moreB || folded[*a] < folded[*b])) {
+            result.push_back(names[*a++].str());
+        } else {
+            result.push_back(names[*b++].str());
+        }
+    }
+    return result;
+}
+
+vector<string> UserSearchIndex::searchBySubstring(const string& query, size_t limit) const {
+    vector<string> result;
+    if (query.empty() || limit == 0) return result;
+    string key = fold(query);
+
+    struct Match {
+        size_t position;
+        size_t length;
+        uint32_t id;
+    };
+    vector<Match> matches;
+
+    shared_lock<shared_mutex> lock(mutex);
+    for (uint32_t id : substringCandidates(key)) {
+        size_t position = folded[id].find(key);
+        if (position != string::npos) {
+            matches.push_back({position, folded[id].size(), id});
+        }
+    }
+
+    // Exact and prefix matches come first (position 0, shortest first), then
+    // the earlier the match and the shorter the name the better
+    auto better = [this](const Match& a, const Match& b) {
+        if (a.position != b.position) return a.position < b.position;
+        if (a.length != b.length) return a.length < b.length;
+        return folded[a.id] < folded[b.id];
+    };
+    size_t shown = min(limit, matches.size());
+    partial_sort(matches.begin(), matches.begin() + shown, matches.end(), better);
+
+    result.reserve(shown);
+    for (size_t i = 0; i < shown; i++) {
+        result.push_back(names[matches[i].id].str());
+    }
+    return result;
+}
+
+vector<string> UserSearchIndex::getAllUsers() const {
+    shared_lock<shared_mutex> lock(mutex);
+    vector<string> result;
+    result.reserve(sorted.size() + pending.size());
+    auto byName = [this](uint32_t a, uint32_t b) { return folded[a] < folded[b]; };
+    vector<uint32_t> order;
+    merge(sorted.begin(), sorted.end(), pending.begin(), pending.end(), back_inserter(order), byName);
+    for (uint32_t id : order) {
+        result.push_back(names[id].str());
+    }
+    return result;
+}
+
+bool UserSearchIndex::userExists(const string& username) const {
+    if (username.empty()) return false;
+    string key = fold(username);
+    shared_lock<shared_mutex> lock(mutex);
+    return containsLocked(key);
+}
+
+size_t UserSearchIndex::size() const {
+    shared_lock<shared_mutex> lock(mutex);
+    return sorted.size() + pending.size();
+}
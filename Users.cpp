@@ -1,5 +1,6 @@
 #include "include/Users.h"
-#include "include/Authentication.h"
+#include "include/PasswordHasher.h"
+#include "include/Snapshot.h"
 #include <fstream>
 #include <stdexcept>
 
@@ -7,30 +8,26 @@ using namespace std;
 using json = nlohmann::json;
 
 // User Class Implementation
-User::User() : hashedPass(""), salt("") { username = ""; }
-User::User(const string& name, const string& hpass, const string& s)
-    : hashedPass(hpass), salt(s) { username = name; }
+User::User() : hashedPass(""), salt(""), iterations(0) { username = ""; }
+User::User(const string& name, const string& hpass, const string& s, uint32_t rounds)
+    : hashedPass(hpass), salt(s), iterations(rounds) { username = name; }
 
 string User::getUsername() const { return username; }
 
 bool User::verifyPass(const string& pass) const {
-    return hashedPass == Authentication::hashPass(pass, salt);
+    return PasswordHasher::matches(hashedPass, PasswordHasher::derive(pass, salt, iterations));
 }
 
 string User::getPass() const { return hashedPass; }
 
 string User::getSalt() const { return salt; }
 
-const AVLTree<string>& User::getFriendTree() const { return friends; }
-
-AVLTree<string>& User::getFriendTree() { return friends; }
-
 json User::toJson() const {
-    return json{{"username", username}, {"hashedPass", hashedPass}, {"salt", salt}};
+    return json{{"username", username}, {"hashedPass", hashedPass}, {"salt", salt}, {"iterations", iterations}};
 }
 
 User User::fromJson(const json& j) {
-    return User(j.at("username"), j.at("hashedPass"), j.at("salt"));
+    return User(j.at("username"), j.at("hashedPass"), j.at("salt"), j.value("iterations", 0u));
 }
 
 // UserStorage Class Implementation
@@ -74,7 +71,38 @@ unordered_map<string, User> UserStorage::loadUsers(const string& filePath) {
         string username = u["username"];
         string hashed = u["hashedPass"];
         string salt = u["salt"];
-        users[username] = User(username, hashed, salt);
+        users[username] = User(username, hashed, salt, u.value("iterations", 0u));
+    }
+    return users;
+}
+// Binary layout: user count, then username, hashed password, salt and
+// (from format version 2) iteration count per user
+void UserStorage::saveUsersBinary(const unordered_map<string, User>& users, const string& filePath) {
+    SnapshotWriter out;
+    out.u32(static_cast<uint32_t>(users.size()));
+    for (const auto& pair : users) {
+        out.symbol(Symbol(pair.first));
+        out.str(pair.second.getPass());
+        out.str(pair.second.getSalt());
+        out.u32(pair.second.getIterations());
+    }
+    out.save(filePath, snapshot::USERS);
+}
+
+unordered_map<string, User> UserStorage::loadUsersBinary(const string& filePath) {
+    SnapshotReader in(filePath, snapshot::USERS);
+    unordered_map<string, User> users;
+    uint32_t count = in.u32();
+    users.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const string& username = in.symbol().str();
+        string hashed(in.str());
+        string salt(in.str());
+        uint32_t iterations = in.version() >= 2 ? in.u32() : 0;
+        users.emplace(username, User(username, hashed, salt, iterations));
+    }
+    if (!in.done()) {
+        throw runtime_error("Trailing data in users snapshot: " + filePath);
     }
     return users;
-}
\ No newline at end of file
+}
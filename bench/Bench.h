@@ -0,0 +1,32 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdlib>
+#include <cstddef>
+
+// Helpers shared by the micro-benchmarks in this directory
+namespace bench {
+
+// Wall-clock milliseconds taken by fn()
+template <typename F>
+double millis(F fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Keeps a computed value alive so the optimizer can't drop the work
+inline void keep(size_t value) {
+    static volatile size_t sink;
+    sink = sink + value;
+}
+
+// argv[1] as a count, or 'fallback'
+inline size_t sizeArg(int argc, char** argv, size_t fallback) {
+    return argc > 1 ? std::strtoull(argv[1], nullptr, 10) : fallback;
+}
+
+} // namespace bench
+
+#endif // BENCH_H
@@ -0,0 +1,89 @@
+// Startup indexing: the time index plus one index per author for N posts
+// (default 1M) over 20k authors, built with one insert per key against the
+// AVLTree bulk constructor, both on a shared NodePool like PostsManager.
+#include "include/AVLTree.h"
+#include "include/NodePool.h"
+#include "bench/Bench.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Same ordering as PostKey in timeline.h, without pulling in the server
+struct Key {
+    time_t timestamp;
+    int id;
+    bool operator<(const Key& other) const {
+        return timestamp != other.timestamp ? timestamp < other.timestamp : id < other.id;
+    }
+    bool operator>(const Key& other) const { return other < *this; }
+    bool operator==(const Key& other) const { return timestamp == other.timestamp && id == other.id; }
+};
+
+struct FakePost {
+    Key key;
+    string owner;
+};
+
+using Index = AVLTree<Key, NodePool<Key>>;
+
+int main(int argc, char** argv) {
+    const size_t n = bench::sizeArg(argc, argv, 1000000);
+    const size_t authors = 20000;
+    mt19937 rng(5);
+    vector<FakePost> posts;
+    posts.reserve(n);
+    time_t now = 1700000000;
+    for (size_t i = 1; i <= n; i++) {
+        now += rng() % 5;
+        posts.push_back({Key{now, static_cast<int>(i)}, "user" + to_string(rng() % authors)});
+    }
+
+    for (int run = 0; run < 3; run++) {
+        size_t insertedSize = 0, bulkSize = 0;
+        double inserted = bench::millis([&] {
+            NodePool<Key> pool;
+            Index timeIndex(pool);
+            unordered_map<string, Index> authorIndex;
+            for (const FakePost& post : posts) {
+                timeIndex.insert(post.key);
+                authorIndex.try_emplace(post.owner, pool).first->second.insert(post.key);
+            }
+            insertedSize = timeIndex.size();
+        });
+
+        // What buildIndexes does: check the order, group by author, build
+        double bulk = bench::millis([&] {
+            NodePool<Key> pool;
+            if (!is_sorted(posts.begin(), posts.end(), [](const FakePost& a, const FakePost& b) { return a.key < b.key; })) {
+                abort();
+            }
+            vector<Key> keys;
+            keys.reserve(posts.size());
+            unordered_map<string, vector<Key>> byAuthor;
+            for (const FakePost& post : posts) {
+                keys.push_back(post.key);
+                byAuthor[post.owner].push_back(post.key);
+            }
+            Index timeIndex(keys.begin(), keys.end(), pool);
+            unordered_map<string, Index> authorIndex;
+            authorIndex.reserve(byAuthor.size());
+            for (auto& entry : byAuthor) {
+                authorIndex.emplace(entry.first, Index(entry.second.begin(), entry.second.end(), pool));
+            }
+            bulkSize = timeIndex.size();
+        });
+
+        if (insertedSize != n || bulkSize != n) {
+            fprintf(stderr, "index sizes %zu / %zu, expected %zu\n", insertedSize, bulkSize, n);
+            return 1;
+        }
+        printf("%zu posts, %zu authors: insert %.0f ms, bulk %.0f ms (%.1fx)\n",
+               n, authors, inserted, bulk, inserted / bulk);
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Feed serialization: JsonWriter straight into the body against building a
+// JSON tree and dumping it, for a page of N posts (default 10k) shaped like
+// writeFeed's output (3 comments and 2 reactions per post). Crow is not
+// needed: the tree path uses nlohmann::json, which copies every string into
+// the tree the same way crow::json::wvalue does.
+#include "include/JsonWriter.h"
+#include "bench/Bench.h"
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+using namespace std;
+using json = nlohmann::json;
+
+struct FakeComment {
+    int id;
+    string content;
+    string owner;
+    long long timestamp;
+};
+
+struct FakePost {
+    int id;
+    string content;
+    string owner;
+    long long timestamp;
+    vector<string> reactions;
+    vector<FakeComment> comments;
+};
+
+static string writeWithWriter(const vector<FakePost>& posts) {
+    string out;
+    out.reserve(posts.size() * 256);
+    JsonWriter writer(out);
+    writer.beginArray();
+    for (const FakePost& post : posts) {
+        writer.beginObject();
+        writer.key("id").value(post.id);
+        writer.key("content").value(post.content);
+        writer.key("owner").value(post.owner);
+        writer.key("timestamp").value(post.timestamp);
+        writer.key("reactions").beginArray();
+        for (const string& user : post.reactions) writer.value(user);
+        writer.endArray();
+        writer.key("reactionCounts").beginObject();
+        writer.key("like").value(static_cast<long long>(post.reactions.size()));
+        writer.endObject();
+        writer.key("comments").beginArray();
+        for (const FakeComment& comment : post.comments) {
+            writer.beginObject();
+            writer.key("id").value(comment.id);
+            writer.key("content").value(comment.content);
+            writer.key("owner").value(comment.owner);
+            writer.key("timestamp").value(comment.timestamp);
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.key("comment_count").value(static_cast<long long>(post.comments.size()));
+        writer.endObject();
+    }
+    writer.endArray();
+    return out;
+}
+
+static string writeWithTree(const vector<FakePost>& posts) {
+    json page = json::array();
+    for (const FakePost& post : posts) {
+        json item;
+        item["id"] = post.id;
+        item["content"] = post.content;
+        item["owner"] = post.owner;
+        item["timestamp"] = post.timestamp;
+        item["reactions"] = post.reactions;
+        item["reactionCounts"] = {{"like", post.reactions.size()}};
+        json comments = json::array();
+        for (const FakeComment& comment : post.comments) {
+            comments.push_back({{"id", comment.id}, {"content", comment.content},
+                                {"owner", comment.owner}, {"timestamp", comment.timestamp}});
+        }
+        item["comments"] = comments;
+        item["comment_count"] = post.comments.size();
+        page.push_back(move(item));
+    }
+    return page.dump();
+}
+
+int main(int argc, char** argv) {
+    const size_t n = bench::sizeArg(argc, argv, 10000);
+    vector<FakePost> posts;
+    posts.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        FakePost post{static_cast<int>(i), "Post number " + to_string(i) + " with a \"quote\" and some text to escape\n",
+                      "user" + to_string(i % 1000), 1700000000 + static_cast<long long>(i), {"alice", "bob"}, {}};
+        for (int c = 0; c < 3; c++) {
+            post.comments.push_back({c + 1, "Comment " + to_string(c) + " on post " + to_string(i),
+                                     "user" + to_string((i + c) % 1000), 1700000000 + static_cast<long long>(i + c)});
+        }
+        posts.push_back(move(post));
+    }
+
+    string fromTree, fromWriter;
+    double tree = bench::millis([&] { fromTree = writeWithTree(posts); });
+    double writer = bench::millis([&] { fromWriter = writeWithWriter(posts); });
+
+    if (json::parse(fromTree) != json::parse(fromWriter)) {
+        fprintf(stderr, "outputs differ\n");
+        return 1;
+    }
+    printf("Feed of %zu posts (%.1f MB): tree + dump %.1f ms, JsonWriter %.1f ms\n",
+           n, fromWriter.size() / 1e6, tree, writer);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Mutual-friend counts for a batch of 200 users: FriendGraph::mutualCounts
+// (one bitset per batch) against the old per-pair neighbour vectors plus a
+// hash set, at 10k / 100k / N users (default 1M) with ~50 friends each.
+#include "include/FriendGraph.h"
+#include "bench/Bench.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+using namespace std;
+
+using UserId = FriendGraph::UserId;
+
+static size_t perPair(const FriendGraph& graph, UserId user, const vector<UserId>& others) {
+    size_t total = 0;
+    for (UserId other : others) {
+        vector<UserId> mine = graph.neighbors(user);
+        vector<UserId> theirs = graph.neighbors(other);
+        unordered_set<UserId> lookup(mine.begin(), mine.end());
+        for (UserId id : theirs) total += lookup.count(id);
+    }
+    return total;
+}
+
+int main(int argc, char** argv) {
+    const size_t largest = bench::sizeArg(argc, argv, 1000000);
+    const size_t askers = 200, batch = 200;
+
+    for (size_t n : {size_t(10000), size_t(100000), largest}) {
+        if (n > largest) continue;
+        FriendGraph graph;
+        vector<UserId> ids(n);
+        for (size_t i = 0; i < n; i++) ids[i] = graph.intern("bench" + to_string(n) + "_" + to_string(i));
+
+        mt19937 rng(1);
+        vector<pair<UserId, UserId>> edges;
+        for (size_t i = 0; i < n * 25; i++) edges.emplace_back(ids[rng() % n], ids[rng() % n]);
+        graph.build(edges);
+
+        // Friends of friends, like the suggestion cards, so most counts are non-zero
+        vector<UserId> users, others;
+        for (size_t i = 0; i < askers; i++) users.push_back(ids[rng() % n]);
+        for (UserId user : users) {
+            for (UserId friendId : graph.neighbors(user)) {
+                vector<UserId> next = graph.neighbors(friendId);
+                if (!next.empty()) others.push_back(next[rng() % next.size()]);
+                if (others.size() == batch) break;
+            }
+            if (others.size() == batch) break;
+        }
+
+        size_t expected = 0, counted = 0;
+        double old = bench::millis([&] {
+            for (UserId user : users) expected += perPair(graph, user, others);
+        });
+        double bitset = bench::millis([&] {
+            for (UserId user : users) {
+                for (uint32_t count : graph.mutualCounts(user, others)) counted += count;
+            }
+        });
+        // perPair doesn't skip asking about yourself; mutualCounts does
+        for (UserId user : users) {
+            expected -= count(others.begin(), others.end(), user) * graph.degree(user);
+        }
+        if (expected != counted) {
+            fprintf(stderr, "%zu users: per-pair found %zu mutual friends, bitset %zu\n", n, expected, counted);
+            return 1;
+        }
+        printf("%8zu users, batch of %zu: per-pair %7.1f us, bitset %5.1f us per batch\n",
+               n, others.size(), old * 1000 / askers, bitset * 1000 / askers);
+    }
+    return 0;
+}
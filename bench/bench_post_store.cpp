@@ -0,0 +1,101 @@
+// PostStore against the linear post vector it replaced: lookups by id,
+// delete + publish and insert + publish at N posts (default 1M).
+#include "include/PostStore.h"
+#include "bench/Bench.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+using namespace std;
+
+// PostStore only holds handles, so a stand-in is enough here
+class Post {
+public:
+    int id;
+    explicit Post(int i) : id(i) {}
+};
+
+// The old layout: one vector searched front to back, copied whole for
+// readers on every change
+struct PostsVec {
+    vector<PostPtr> posts;
+    shared_ptr<const vector<PostPtr>> published;
+
+    PostPtr find(int id) const {
+        auto it = find_if(posts.begin(), posts.end(), [id](const PostPtr& p) { return p->id == id; });
+        return it == posts.end() ? nullptr : *it;
+    }
+    void erase(int id) {
+        auto it = find_if(posts.begin(), posts.end(), [id](const PostPtr& p) { return p->id == id; });
+        if (it != posts.end()) posts.erase(it);
+    }
+    void publish() { published = make_shared<const vector<PostPtr>>(posts); }
+};
+
+int main(int argc, char** argv) {
+    const size_t n = bench::sizeArg(argc, argv, 1000000);
+    const int lookups = 1000, changes = 200;
+    mt19937 rng(42);
+
+    PostStore store;
+    PostsVec vec;
+    for (size_t i = 1; i <= n; i++) {
+        PostPtr post = make_shared<Post>(static_cast<int>(i));
+        store.insert(post->id, post);
+        vec.posts.push_back(post);
+    }
+    store.publish();
+    vec.publish();
+
+    vector<int> ids(lookups);
+    for (int& id : ids) id = static_cast<int>(rng() % n) + 1;
+
+    double vecFind = bench::millis([&] {
+        for (int id : ids) bench::keep(vec.find(id)->id);
+    });
+    double storeFind = bench::millis([&] {
+        for (int id : ids) bench::keep(store.find(id)->id);
+    });
+
+    vector<int> victims(changes);
+    for (int& id : victims) id = static_cast<int>(rng() % n) + 1;
+    sort(victims.begin(), victims.end());
+    victims.erase(unique(victims.begin(), victims.end()), victims.end());
+
+    double vecDelete = bench::millis([&] {
+        for (int id : victims) {
+            vec.erase(id);
+            vec.publish();
+        }
+    });
+    double storeDelete = bench::millis([&] {
+        for (int id : victims) {
+            store.erase(id);
+            store.publish();
+        }
+    });
+
+    int nextId = static_cast<int>(n) + 1;
+    double vecInsert = bench::millis([&] {
+        for (int i = 0; i < changes; i++) {
+            vec.posts.push_back(make_shared<Post>(nextId + i));
+            vec.publish();
+        }
+    });
+    double storeInsert = bench::millis([&] {
+        for (int i = 0; i < changes; i++) {
+            store.insert(nextId + i, make_shared<Post>(nextId + i));
+            store.publish();
+        }
+    });
+
+    printf("PostStore, %zu posts (per operation)\n", n);
+    printf("  find:             vector %10.2f us   store %8.2f us\n",
+           vecFind * 1000 / lookups, storeFind * 1000 / lookups);
+    printf("  delete + publish: vector %10.2f us   store %8.2f us\n",
+           vecDelete * 1000 / victims.size(), storeDelete * 1000 / victims.size());
+    printf("  insert + publish: vector %10.2f us   store %8.2f us\n",
+           vecInsert * 1000 / changes, storeInsert * 1000 / changes);
+    return 0;
+}
@@ -0,0 +1,47 @@
+// Session token generation: SecureRandom's per-thread buffer against the
+// old rand() % 62 loop, at 1 to N threads (default 8).
+#include "include/SecureRandom.h"
+#include "bench/Bench.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+static string randToken(size_t length) {
+    static const char chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    string token;
+    for (size_t i = 0; i < length; i++) token += chars[rand() % 62];
+    return token;
+}
+
+int main(int argc, char** argv) {
+    const size_t maxThreads = bench::sizeArg(argc, argv, 8);
+    const size_t tokens = 400000;
+
+    printf("32-char tokens, %zu in total per run (M tokens/s)\n", tokens);
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        double rates[2];
+        for (int secure = 0; secure < 2; secure++) {
+            size_t each = tokens / threads;
+            double ms = bench::millis([&] {
+                vector<thread> workers;
+                for (size_t t = 0; t < threads; t++) {
+                    workers.emplace_back([&] {
+                        size_t sum = 0;
+                        for (size_t i = 0; i < each; i++) {
+                            sum += secure ? static_cast<unsigned char>(SecureRandom::token(32)[0])
+                                          : static_cast<unsigned char>(randToken(32)[0]);
+                        }
+                        bench::keep(sum);
+                    });
+                }
+                for (thread& worker : workers) worker.join();
+            });
+            rates[secure] = each * threads / ms / 1000;
+        }
+        printf("  %2zu threads: rand() %.2f, SecureRandom %.2f\n", threads, rates[0], rates[1]);
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Substring user search: the trigram index against a scan of every folded
+// name (what UserSearchBST did), over N random names (default 1M).
+#include "include/UserSearchIndex.h"
+#include "bench/Bench.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+int main(int argc, char** argv) {
+    const size_t n = bench::sizeArg(argc, argv, 1000000);
+    mt19937 rng(7);
+    vector<string> names;
+    names.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        string name(6 + rng() % 8, ' ');
+        for (char& c : name) c = static_cast<char>('a' + rng() % 26);
+        names.push_back(name + to_string(i)); // unique
+    }
+
+    UserSearchIndex index;
+    double build = bench::millis([&] { index.rebuildFromUsers(names); });
+    vector<string> folded;
+    folded.reserve(n);
+    for (const string& name : names) folded.push_back(UserSearchIndex::fold(name));
+
+    printf("User search over %zu names (index build %.0f ms)\n", n, build);
+    for (const char* query : {"abc", "hello", "mnop", "ab"}) {
+        size_t scanned = 0, indexed = 0, limited = 0;
+        double scan = bench::millis([&] {
+            for (const string& name : folded) scanned += name.find(query) != string::npos;
+        });
+        double full = bench::millis([&] { indexed = index.searchBySubstring(query).size(); });
+        double top = bench::millis([&] { limited = index.searchBySubstring(query, 10).size(); });
+        if (scanned != indexed) {
+            fprintf(stderr, "\"%s\": scan found %zu, index %zu\n", query, scanned, indexed);
+            return 1;
+        }
+        printf("  \"%s\" (%zu hits): scan %.2f ms, index %.3f ms, limit=10 %.3f ms (%zu)\n",
+               query, indexed, scan, full, top, limited);
+    }
+
+    vector<string> signups;
+    for (int i = 0; i < 10000; i++) signups.push_back("newuser" + to_string(i) + "x");
+    double inserts = bench::millis([&] {
+        for (const string& name : signups) index.insertUser(name);
+    });
+    printf("  %zu signups: %.0f ms\n", signups.size(), inserts);
+    return 0;
+}
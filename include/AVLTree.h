@@ -3,9 +3,20 @@
 
 #include <iostream>
 #include <vector>
+#include <memory>
 #include <algorithm>
-
-template <typename T>
+#include <cstddef>
+#include <iterator>
+
+// Balanced binary search tree of unique keys.
+//  - Nodes come from 'Allocator' (rebound to the node type), so trees can
+//    share a NodePool instead of calling new/delete per node.
+//  - Every node keeps the size of its subtree: size() is O(1), and
+//    select()/rank() find the k-th key or a key's position in O(log n).
+//  - Traversals and teardown are iterative, so no walk recurses deeper
+//    than insert/remove do (O(log n)). Readers can stream with an
+//    iterator, visit() or visitRange() instead of copying with inOrder().
+template <typename T, typename Allocator = std::allocator<T>>
 class AVLTree {
 private:
     struct Node {
@@ -13,16 +24,50 @@ private:
         Node* left;
         Node* right;
         int height;
+        size_t size; // nodes in this subtree
 
-        Node(const T& val) : data(val), left(nullptr), right(nullptr), height(1) {}
+        Node(const T& val) : data(val), left(nullptr), right(nullptr), height(1), size(1) {}
     };
 
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+    // An AVL tree of height h has at least fib(h + 2) - 1 nodes, so 64
+    // levels would take more nodes than fit in memory
+    static constexpr int MAX_HEIGHT = 64;
+
+    NodeAllocator alloc;
     Node* root;
 
+    Node* createNode(const T& val) {
+        Node* node = NodeTraits::allocate(alloc, 1);
+        try {
+            NodeTraits::construct(alloc, node, val);
+        } catch (...) {
+            NodeTraits::deallocate(alloc, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroyNode(Node* node) {
+        NodeTraits::destroy(alloc, node);
+        NodeTraits::deallocate(alloc, node, 1);
+    }
+
     int height(Node* node) const {
         return node ? node->height : 0;
     }
 
+    static size_t count(Node* node) {
+        return node ? node->size : 0;
+    }
+
+    void update(Node* node) {
+        node->height = 1 + std::max(height(node->left), height(node->right));
+        node->size = 1 + count(node->left) + count(node->right);
+    }
+
     int getBalance(Node* node) const {
         return node ? height(node->left) - height(node->right) : 0;
     }
@@ -34,8 +79,8 @@ private:
         x->right = y;
         y->left = T2;
 
-        y->height = std::max(height(y->left), height(y->right)) + 1;
-        x->height = std::max(height(x->left), height(x->right)) + 1;
+        update(y);
+        update(x);
 
         return x;
     }
@@ -47,14 +92,14 @@ private:
         y->left = x;
         x->right = T2;
 
-        x->height = std::max(height(x->left), height(x->right)) + 1;
-        y->height = std::max(height(y->left), height(y->right)) + 1;
+        update(x);
+        update(y);
 
         return y;
     }
 
     Node* insert(Node* node, const T& key) {
-        if (!node) return new Node(key);
+        if (!node) return createNode(key);
 
         if (key < node->data)
             node->left = insert(node->left, key);
@@ -63,7 +108,7 @@ private:
         else
             return node; // duplicate, do nothing
 
-        node->height = 1 + std::max(height(node->left), height(node->right));
+        update(node);
         int balance = getBalance(node);
 
         // Rebalance if needed
@@ -93,7 +138,7 @@ private:
         else {
             if (!node->left || !node->right) {
                 Node* temp = node->left ? node->left : node->right;
-                delete node;
+                destroyNode(node);
                 return temp;
             }
 
@@ -105,7 +150,7 @@ private:
             node->right = remove(node->right, temp->data);
         }
 
-        node->height = 1 + std::max(height(node->left), height(node->right));
+        update(node);
         int balance = getBalance(node);
 
         // Rebalance
@@ -125,38 +170,81 @@ private:
         return node;
     }
 
-    bool contains(Node* node, const T& key) const {
-        if (!node) return false;
-        if (key == node->data) return true;
-        if (key < node->data) return contains(node->left, key);
-        return contains(node->right, key);
-    }
-
-    void inOrder(Node* node, std::vector<T>& result) const {
-        if (!node) return;
-        inOrder(node->left, result);
-        result.push_back(node->data);
-        inOrder(node->right, result);
+    // Perfectly balanced subtree of the next n elements of 'it': the middle
+    // one at the root, so the two sides differ by at most one node
+    template <typename It>
+    Node* build(It& it, size_t n) {
+        if (n == 0) return nullptr;
+        size_t leftCount = (n - 1) / 2;
+        Node* left = build(it, leftCount);
+        Node* node;
+        try {
+            node = createNode(*it);
+        } catch (...) {
+            destroy(left);
+            throw;
+        }
+        ++it;
+        node->left = left;
+        try {
+            node->right = build(it, n - 1 - leftCount);
+        } catch (...) {
+            destroy(node);
+            throw;
+        }
+        update(node);
+        return node;
     }
 
+    // Rotates left children up until there are none, then frees the node
+    // and moves right: O(n) with no stack
     void destroy(Node* node) {
-        if (!node) return;
-        destroy(node->left);
-        destroy(node->right);
-        delete node;
-    }
-    int size(Node* node) const {
-        if (!node) return 0;
-        return 1 + size(node->left) + size(node->right);
+        while (node) {
+            if (node->left) {
+                Node* left = node->left;
+                node->left = left->right;
+                left->right = node;
+                node = left;
+            } else {
+                Node* right = node->right;
+                destroyNode(node);
+                node = right;
+            }
+        }
     }
 
 public:
-    AVLTree() : root(nullptr) {}
+    AVLTree() : alloc(), root(nullptr) {}
+    explicit AVLTree(const Allocator& allocator) : alloc(allocator), root(nullptr) {}
+
+    // Bulk load from strictly ascending input in O(n), with no comparisons
+    // or rotations. Unsorted or duplicate input gives a broken tree.
+    template <typename It>
+    AVLTree(It first, It last, const Allocator& allocator = Allocator()) : alloc(allocator), root(nullptr) {
+        root = build(first, static_cast<size_t>(std::distance(first, last)));
+    }
 
     ~AVLTree() {
         destroy(root);
     }
 
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
+
+    AVLTree(AVLTree&& other) noexcept : alloc(other.alloc), root(other.root) {
+        other.root = nullptr;
+    }
+
+    AVLTree& operator=(AVLTree&& other) noexcept {
+        if (this != &other) {
+            destroy(root);
+            alloc = other.alloc;
+            root = other.root;
+            other.root = nullptr;
+        }
+        return *this;
+    }
+
     void insert(const T& key) {
         root = insert(root, key);
     }
@@ -166,20 +254,166 @@ public:
     }
 
     bool contains(const T& key) const {
-        return contains(root, key);
+        Node* node = root;
+        while (node) {
+            if (key == node->data) return true;
+            node = key < node->data ? node->left : node->right;
+        }
+        return false;
+    }
+
+    // Ascending, read-only. Holds the path to the current node, so it is
+    // invalidated by any insert or remove on the tree.
+    class const_iterator {
+    private:
+        friend class AVLTree;
+        Node* stack[MAX_HEIGHT];
+        int depth = 0;
+
+        void pushLeft(Node* node) {
+            for (; node; node = node->left) stack[depth++] = node;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        reference operator*() const { return stack[depth - 1]->data; }
+        pointer operator->() const { return &stack[depth - 1]->data; }
+
+        const_iterator& operator++() {
+            Node* node = stack[--depth];
+            pushLeft(node->right);
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            if (depth != other.depth) return false;
+            return depth == 0 || stack[depth - 1] == other.stack[depth - 1];
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+    };
+
+    const_iterator begin() const {
+        const_iterator it;
+        it.pushLeft(root);
+        return it;
+    }
+
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    // First element not less than 'key', or end()
+    const_iterator lower_bound(const T& key) const {
+        // Only nodes >= key stay on the stack: they are exactly the ones
+        // an in-order walk from the result still has to visit
+        const_iterator it;
+        Node* node = root;
+        while (node) {
+            if (node->data < key) {
+                node = node->right;
+            } else {
+                it.stack[it.depth++] = node;
+                node = node->left;
+            }
+        }
+        return it;
+    }
+
+    // Visit every element in ascending order until fn returns false
+    template <typename F>
+    void visit(F fn) const {
+        for (const_iterator it = begin(); it != end(); ++it) {
+            if (!fn(*it)) return;
+        }
+    }
+
+    // Visit elements in [low, high), ascending, until fn returns false.
+    // O(log n + visited).
+    template <typename F>
+    void visitRange(const T& low, const T& high, F fn) const {
+        for (const_iterator it = lower_bound(low); it != end() && *it < high; ++it) {
+            if (!fn(*it)) return;
+        }
     }
 
     std::vector<T> inOrder() const {
         std::vector<T> result;
-        inOrder(root, result);
+        result.reserve(size());
+        visit([&result](const T& value) {
+            result.push_back(value);
+            return true;
+        });
         return result;
     }
 
-    int size() const {
-        return size(root);
+    // Visit elements strictly less than 'bound', largest first, until fn returns false.
+    // O(log n + visited).
+    template <typename F>
+    void visitDescendingBelow(const T& bound, F fn) const {
+        Node* stack[MAX_HEIGHT];
+        int depth = 0;
+        Node* node = root;
+        while (node || depth > 0) {
+            // Node and its right subtree are all >= bound: go left
+            while (node) {
+                if (node->data < bound) {
+                    stack[depth++] = node;
+                    node = node->right;
+                } else {
+                    node = node->left;
+                }
+            }
+            node = stack[--depth];
+            if (!fn(node->data)) return;
+            node = node->left;
+        }
+    }
+
+    size_t size() const {
+        return count(root);
     }
 
-    
+    // The k-th smallest element (from 0), or nullptr if k >= size()
+    const T* select(size_t k) const {
+        Node* node = root;
+        while (node) {
+            size_t left = count(node->left);
+            if (k < left) {
+                node = node->left;
+            } else if (k == left) {
+                return &node->data;
+            } else {
+                k -= left + 1;
+                node = node->right;
+            }
+        }
+        return nullptr;
+    }
+
+    // How many elements are strictly less than 'key'
+    size_t rank(const T& key) const {
+        size_t result = 0;
+        Node* node = root;
+        while (node) {
+            if (node->data < key) {
+                result += count(node->left) + 1;
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+        return result;
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
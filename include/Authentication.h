@@ -3,28 +3,50 @@
 #include <bits/stdc++.h>
 #include <nlohmann/json.hpp>
 #include "Users.h"
+#include "SymbolTable.h"
+#include "SessionStore.h"
+#include "SignedTokens.h"
+#include "PasswordHasher.h"
 using namespace std;
 class Authentication 
 {
     //maps usernames to their users
     unordered_map<string, User> usersByUsername;
-    //maps tokens to usernames
-    unordered_map<string, string> sessions;
-    //maps users to tokens
-    unordered_map<string, string> usersnameToToken;
-    string db_path_;
+    // Login sessions: sharded, expiring, persisted in the background
+    unique_ptr<SessionStore> sessions;
+    // Set when SESSION_TOKENS=signed: login hands out stateless signed
+    // tokens instead. Table tokens stay valid either way.
+    unique_ptr<SignedTokens> signedTokens;
+    // Runs the (deliberately slow) password hashing off the request threads
+    PasswordHasher hasher;
+    string db_path_;        // users.json, imported when there is no binary snapshot
+    string users_snapshot_path_;
     string sessions_path_;
+    // usersMutex guards usersByUsername (shared with FriendsManager, which
+    // also guards its friend graph with it); the session store has its own locks
+    mutable shared_mutex usersMutex;
+    // Orders users.bin rewrites; held while writing, usersMutex is not
+    mutex saveMutex;
+    void saveUsersSnapshot();
+    // The user behind a live table or signed token
+    bool findSession(const string& token, string& name) const;
+    // Rehash with a fresh salt at the current iteration count
+    void upgradeHash(const string& name, const string& pass, const string& oldHash);
     public:
     Authentication(const string& db_path);
     
     string login (string name, string pass);
     void signup (string name, string pass);
     void logout(const string& token);
+    // New session for a user whose password was already checked, e.g.
+    // right after signup, without hashing the password again
+    string startSession(const string& name);
 
     User* getUserByToken (const string& token);
     bool isLoggedIn(const string& token)const;
     string verifyToken(const string& token); // Returns username if token is valid, throws exception if not
 
+    // Single-round legacy hash; see PasswordHasher for the current scheme
     static string hashPass (const string& pass, const string& salt);
     static string generateSalt ();
     static string generateSession();
@@ -34,7 +56,11 @@ class Authentication
     void loadSessions();
     void saveSessions();
     
+    // Write users.json (the binary snapshot stays authoritative)
+    void exportUsersJson(const string& path) const;
+
     // Access to users map for FriendsManager
     unordered_map<string, User>& getUsers();
+    shared_mutex& getUsersMutex();
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef COMMENT_STORE_H
+#define COMMENT_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <shared_mutex>
+#include <ctime>
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include "SymbolTable.h"
+#include "ContentHeap.h"
+
+class Comment {
+    int commentId;
+    int postId;
+    Symbol owner; // interned username
+    TextRef content; // text in the ContentHeap
+    time_t timestamp;
+public:
+    Comment(int id, int pId, const std::string& o, std::string_view c);
+    Comment(int id, int pId, Symbol o, std::string_view c, time_t time);
+    int getCommentId() const;
+    void setContent(std::string_view c);
+    void setTimestamp(time_t newTime);
+    std::string_view getCommentContent() const;
+    TextRef getContentRef() const { return content; }
+    const std::string& getCommentOwner() const;
+    time_t getCommentTimes() const;
+    int getPostId() const { return postId; }
+    nlohmann::json CommentToJson() const;
+    static Comment CommentFromJson(const nlohmann::json& Json);
+};
+
+// Comment threads kept apart from the posts, keyed by (postId, commentId).
+//  - Each thread is an ordered map by comment id (= creation order), so
+//    find/edit/delete are O(log n) and a page after a given id is a
+//    lower_bound plus a scan.
+//  - Posts only carry a count and a short preview, so copying a post or
+//    serializing a feed no longer drags every comment along.
+// The thread table is guarded internally; the comments of one post are
+// guarded by that post's lock (PostsManager::postLock), which callers hold.
+// Comments overwritten, erased or dropped here release their text in the
+// ContentHeap.
+class CommentStore {
+private:
+    using Thread = std::map<int, Comment>;
+
+    std::unordered_map<int, Thread> threads;
+    mutable std::shared_mutex mutex; // guards the table, not the threads
+
+    Thread* thread(int postId);
+    const Thread* thread(int postId) const;
+
+public:
+    // Inserts the comment, or overwrites (and releases) the one with the same id
+    void put(const Comment& comment);
+    Comment* find(int postId, int commentId);
+    bool erase(int postId, int commentId);
+    void dropPost(int postId);
+    void clear();
+
+    size_t count(int postId) const;
+    // The newest 'limit' comments, oldest first
+    std::vector<Comment> latest(int postId, size_t limit) const;
+    // Up to 'limit' comments with ids above 'afterId', oldest first
+    std::vector<Comment> page(int postId, int afterId, size_t limit, bool& hasMore) const;
+
+    // fn(const Comment&) over the whole thread, oldest first
+    template<typename F>
+    void forEach(int postId, F fn) const;
+};
+
+template<typename F>
+void CommentStore::forEach(int postId, F fn) const {
+    if (const Thread* comments = thread(postId)) {
+        for (const auto& entry : *comments) fn(entry.second);
+    }
+}
+
+#endif // COMMENT_STORE_H
@@ -0,0 +1,66 @@
+#ifndef CONTENT_HEAP_H
+#define CONTENT_HEAP_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// Where a piece of text lives in the ContentHeap; 12 bytes, copied freely.
+// The default (empty) reference is the empty string.
+struct TextRef {
+    uint32_t segment = 0;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+// Process-wide, append-only heap for post and comment text.
+//  - Text is copied in once and never moved or modified, so views into it
+//    stay valid for the life of the process and readers need no lock.
+//  - Segments are memory-mapped from unlinked temporary files, so cold
+//    text is backed by the page cache rather than anonymous memory and the
+//    kernel can write it out under pressure. If a file can't be created the
+//    segment falls back to anonymous memory.
+//  - Edits and deletes append/abandon text instead of freeing it; release()
+//    only keeps count of the dead bytes. The space comes back when the
+//    server restarts from a snapshot, which only carries live text.
+class ContentHeap {
+private:
+    static constexpr size_t SEGMENT_SIZE = size_t(4) << 20; // 4 MiB
+    static constexpr size_t MAX_SEGMENTS = size_t(1) << 16;
+
+    std::unique_ptr<std::atomic<char*>[]> segments;
+    std::unique_ptr<size_t[]> segmentSizes;
+    size_t segmentCount = 0;
+    size_t active = 0;     // segment that small appends go to
+    size_t activeUsed = 0; // bytes used in it
+    std::atomic<size_t> usedBytes{0};
+    std::atomic<size_t> deadBytes{0};
+    std::mutex appendMutex;
+
+    ContentHeap();
+    size_t addSegment(size_t size);
+
+public:
+    ~ContentHeap();
+    ContentHeap(const ContentHeap&) = delete;
+    ContentHeap& operator=(const ContentHeap&) = delete;
+
+    static ContentHeap& global();
+
+    TextRef append(std::string_view text);
+    std::string_view view(TextRef ref) const {
+        if (ref.length == 0) return {};
+        return std::string_view(segments[ref.segment].load(std::memory_order_acquire) + ref.offset, ref.length);
+    }
+    // The text is no longer referenced (for the dead-byte count only)
+    void release(TextRef ref) { deadBytes.fetch_add(ref.length, std::memory_order_relaxed); }
+
+    size_t bytesUsed() const { return usedBytes.load(std::memory_order_relaxed); }
+    size_t bytesDead() const { return deadBytes.load(std::memory_order_relaxed); }
+};
+
+#endif // CONTENT_HEAP_H
@@ -0,0 +1,136 @@
+#ifndef FRIEND_GRAPH_H
+#define FRIEND_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include "SymbolTable.h"
+
+// Undirected friendship graph over dense integer user ids.
+//  - Users get their own dense 4-byte ids, handed out in the order the
+//    graph first sees them; edges only store those. The ids are separate
+//    from the global SymbolTable ids, which also number reaction types and
+//    any name a request happens to mention, so the arrays below (and the
+//    mutual-friend bitset) are sized by the users in the graph rather than
+//    by every symbol ever interned.
+//  - The bulk of the edges live in a CSR layout: 'targets' holds every
+//    user's sorted neighbour ids back to back and 'offsets[u]..offsets[u+1]'
+//    delimits user u's run. That is two flat arrays for the whole graph
+//    instead of one heap node (and one string copy) per edge.
+//  - Recent changes go into small sorted per-user delta lists (added /
+//    removed) that are folded back into the CSR arrays once they grow past
+//    an eighth of the graph, so a mutation stays cheap and rebuilds are
+//    amortized O(1) per change.
+// Membership is a binary search, neighbour lists come out sorted by id and
+// mutual friends are a linear merge.
+// Not synchronized: the owner (FriendsManager) guards it.
+class FriendGraph {
+public:
+    using UserId = uint32_t;
+
+private:
+    std::vector<SymbolId> symbols; // UserId -> global symbol
+    std::unordered_map<SymbolId, UserId> ids;
+
+    std::vector<uint32_t> offsets{0}; // CSR row starts, one per base user + 1
+    std::vector<UserId> targets;
+    std::unordered_map<UserId, std::vector<UserId>> added;
+    std::unordered_map<UserId, std::vector<UserId>> removed;
+    size_t deltaEntries = 0;
+    size_t edges = 0;
+
+    static constexpr size_t MIN_COMPACT_DELTA = 4096;
+
+    size_t baseUsers() const { return offsets.size() - 1; }
+    bool baseHas(UserId a, UserId b) const;
+    static bool sortedContains(const std::unordered_map<UserId, std::vector<UserId>>& lists, UserId a, UserId b);
+    static void sortedInsert(std::unordered_map<UserId, std::vector<UserId>>& lists, UserId a, UserId b);
+    static bool sortedErase(std::unordered_map<UserId, std::vector<UserId>>& lists, UserId a, UserId b);
+    void addDirected(UserId a, UserId b);
+    void removeDirected(UserId a, UserId b);
+    void maybeCompact();
+
+public:
+    UserId intern(const std::string& name);
+    UserId intern(Symbol user);
+    bool lookup(const std::string& name, UserId& id) const;
+    Symbol symbol(UserId id) const { return Symbol::fromId(symbols[id]); }
+    const std::string& name(UserId id) const { return SymbolTable::global().name(symbols[id]); }
+    size_t userCount() const { return symbols.size(); }
+    size_t edgeCount() const { return edges; }
+
+    // Both return false if nothing changed
+    bool addEdge(UserId a, UserId b);
+    bool removeEdge(UserId a, UserId b);
+    bool hasEdge(UserId a, UserId b) const;
+    size_t degree(UserId user) const;
+
+    // Neighbours in ascending id order
+    template<typename F>
+    void forEachNeighbor(UserId user, F fn) const;
+    std::vector<UserId> neighbors(UserId user) const;
+    std::vector<UserId> mutual(UserId a, UserId b) const;
+    // Mutual friends of 'user' with each of 'others': fn(index into
+    // others, shared friend id), ascending ids per index. The user's
+    // friends go into a bitset once, then each other user's list is probed
+    // against it, so a batch costs deg(user) + the sum of the others'
+    // degrees and allocates nothing after the first call on a thread.
+    template<typename F>
+    void forEachMutual(UserId user, const std::vector<UserId>& others, F fn) const;
+    std::vector<uint32_t> mutualCounts(UserId user, const std::vector<UserId>& others) const;
+
+    // Replace all edges at once (used when loading a snapshot)
+    void build(const std::vector<std::pair<UserId, UserId>>& edgeList);
+    // Fold the delta lists into the CSR arrays
+    void compact();
+    void clear();
+    size_t memoryBytes() const;
+};
+
+template<typename F>
+void FriendGraph::forEachNeighbor(UserId user, F fn) const {
+    static const std::vector<UserId> none;
+    const UserId* base = nullptr;
+    const UserId* baseEnd = nullptr;
+    if (user < baseUsers()) {
+        base = targets.data() + offsets[user];
+        baseEnd = targets.data() + offsets[user + 1];
+    }
+    auto addedIt = added.find(user);
+    auto removedIt = removed.find(user);
+    const auto& extra = addedIt != added.end() ? addedIt->second : none;
+    const auto& gone = removedIt != removed.end() ? removedIt->second : none;
+
+    // Merge (base - gone) with extra; all three are sorted
+    auto e = extra.begin();
+    auto g = gone.begin();
+    for (; base != baseEnd; ++base) {
+        while (e != extra.end() && *e < *base) fn(*e++);
+        while (g != gone.end() && *g < *base) ++g;
+        if (g != gone.end() && *g == *base) continue;
+        fn(*base);
+    }
+    while (e != extra.end()) fn(*e++);
+}
+
+template<typename F>
+void FriendGraph::forEachMutual(UserId user, const std::vector<UserId>& others, F fn) const {
+    if (user >= userCount() || others.empty()) return;
+    thread_local std::vector<uint64_t> bits;
+    if (bits.size() < (userCount() + 63) / 64) bits.resize((userCount() + 63) / 64, 0);
+    forEachNeighbor(user, [](UserId id) { bits[id >> 6] |= uint64_t(1) << (id & 63); });
+
+    for (size_t i = 0; i < others.size(); i++) {
+        if (others[i] >= userCount() || others[i] == user) continue;
+        forEachNeighbor(others[i], [&](UserId id) {
+            if (bits[id >> 6] & (uint64_t(1) << (id & 63))) fn(i, id);
+        });
+    }
+    // Clear only what we set, so the next call starts from zeros
+    forEachNeighbor(user, [](UserId id) { bits[id >> 6] = 0; });
+}
+
+#endif // FRIEND_GRAPH_H
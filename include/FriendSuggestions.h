@@ -0,0 +1,59 @@
+#ifndef FRIEND_SUGGESTIONS_H
+#define FRIEND_SUGGESTIONS_H
+
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include "FriendGraph.h"
+
+struct FriendSuggestion {
+    FriendGraph::UserId user;
+    uint32_t mutualFriends;
+    uint32_t interactions; // reactions/comments by the asker on this user's posts
+};
+
+// Ranked friend-of-friend suggestions with a per-user cache.
+//  - A user's list is built in one pass over their friends' neighbour
+//    lists, counting mutual friends in a dense per-thread array indexed by
+//    user id, then keeping the TOP_K best: most mutual friends first, then
+//    most interactions, then lowest id.
+//  - Lists are cached until something that could change them happens: an
+//    edge (a, b) drops the lists of a, b and all their friends, a friend
+//    request drops both users' lists. Everyone else keeps theirs.
+//  - Interactions are only counted in memory; they are a tie-breaker and
+//    start from zero after a restart.
+// Not synchronized with the graph: the owner (FriendsManager) calls in with
+// the graph locked. The cache and interaction counts have their own locks.
+class FriendSuggestions {
+public:
+    using UserId = FriendGraph::UserId;
+    static constexpr size_t TOP_K = 50;
+
+private:
+    std::unordered_map<UserId, std::vector<FriendSuggestion>> cache;
+    std::mutex cacheMutex;
+    // actor -> (post owner -> count)
+    std::unordered_map<UserId, std::unordered_map<UserId, uint32_t>> interactions;
+    mutable std::mutex interactionsMutex;
+
+    std::vector<FriendSuggestion> compute(const FriendGraph& graph, UserId user,
+                                          const std::function<bool(UserId)>& excluded) const;
+
+public:
+    // The best 'limit' (at most TOP_K) suggestions for 'user'. 'excluded'
+    // filters out candidates on a fresh computation (pending requests).
+    std::vector<FriendSuggestion> top(const FriendGraph& graph, UserId user, size_t limit,
+                                      const std::function<bool(UserId)>& excluded);
+
+    // Call after the edge changed, with the graph still locked
+    void edgeChanged(const FriendGraph& graph, UserId a, UserId b);
+    void invalidate(UserId user);
+    void clear();
+
+    void noteInteraction(UserId actor, UserId owner);
+};
+
+#endif // FRIEND_SUGGESTIONS_H
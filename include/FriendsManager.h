@@ -5,21 +5,83 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
-#include "Users.h" // Make sure this includes User and its AVLTree
+#include <shared_mutex>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include "Users.h"
+#include "Journal.h"
+#include "FriendGraph.h"
+#include "FriendSuggestions.h"
+#include "Snapshot.h"
 #include <fstream>
 #include <sstream>
 
+struct MutualFriends {
+    std::string user;
+    uint32_t count = 0;
+    std::vector<std::string> names; // sorted; only filled on request
+};
+
 class FriendsManager {
 private:
     // Reference to the global user storage (shared from Authentication or main)
     std::unordered_map<std::string, User>& users;
+    // Lock owned by Authentication that guards 'users'; it also guards 'graph'
+    std::shared_mutex& usersMutex;
+    // Friendships between users, by interned user id
+    FriendGraph graph;
+    // Ranked friend-of-friend lists, cached per user
+    FriendSuggestions suggestions;
+
+    // Keeps track of pending friend requests: toUser -> set of users who sent requests
+    std::unordered_map<Symbol, std::unordered_set<Symbol>> pendingRequests;
+    // Lock order: usersMutex before pendingMutex
+    mutable std::shared_mutex pendingMutex;
+
+    // Called after a friendship is created (added = true) or removed
+    std::function<void(const std::string&, const std::string&, bool added)> friendshipListener;
 
-    // Keeps track of pending friend requests: toUser -> set of usernames who sent requests
-    std::unordered_map<std::string, std::unordered_set<std::string>> pendingRequests;
+    // Friend-graph persistence: snapshots plus an append-only edge log of every
+    // change made since (friend_add, friend_remove, request, request_cancel).
+    // Records are appended under the lock that guards the change, so the log
+    // order matches the in-memory order; a background thread folds the log
+    // back into the snapshots once it grows past 'compactThreshold'.
+    // Compaction writes one binary snapshot ("<friendsFile>" with a .bin
+    // extension) holding both; the JSON files are only imported when it is missing.
+    std::unique_ptr<Journal> edgeLog;
+    std::string friendsPath;
+    std::string pendingPath;
+    std::string snapshotPath;
+    std::mutex compactMutex; // one compaction at a time
+    size_t compactThreshold = 1000;
+    std::chrono::seconds compactInterval{30};
+    std::thread compactor;
+    std::mutex compactorMutex;
+    std::condition_variable compactorCv;
+    bool stopCompactor = false;
+
+    bool areFriendsLocked(const std::string& userA, const std::string& userB) const;
+    std::vector<std::string> friendNamesLocked(const std::string& username) const;
+    void notifyFriendship(const std::string& userA, const std::string& userB, bool added);
+    // A request between the two changed; their suggestion lists are stale
+    void invalidateSuggestions(const std::string& userA, const std::string& userB);
+    void logEdge(const nlohmann::json& record);
+    void applyRecord(const nlohmann::json& record);
+    void compactorLoop();
+    nlohmann::json friendsToJsonLocked() const;
+    nlohmann::json pendingToJsonLocked() const;
+    static void writeSnapshot(const std::string& filename, const nlohmann::json& data);
+    void writeBinaryLocked(SnapshotWriter& out) const;
+    void loadBinary();
 
 public:
-    // Constructor takes reference to existing user storage
-    FriendsManager(std::unordered_map<std::string, User>& usersMap);
+    // Constructor takes reference to existing user storage and the lock that guards it
+    FriendsManager(std::unordered_map<std::string, User>& usersMap, std::shared_mutex& usersMapMutex);
+    ~FriendsManager();
 
     // Core friendship operations
     bool sendFriendRequest(const std::string& from, const std::string& to);
@@ -30,20 +92,40 @@ public:
 
     // Info and utility functions
     std::vector<std::string> getFriendList(const std::string& username) const;
+    // Up to 'limit' friends whose names sort after 'after', by name. Only the
+    // page is sorted and copied, so walking a long list costs O(degree) per page.
+    std::vector<std::string> getFriendPage(const std::string& username, const std::string& after,
+                                           size_t limit, bool& hasMore) const;
     std::vector<std::string> getPendingRequests(const std::string& username) const;
     bool areFriends(const std::string& userA, const std::string& userB) const;
 
     // Mutual and suggestion logic
     std::vector<std::string> getMutualFriends(const std::string& userA, const std::string& userB) const;
-    std::vector<std::string> suggestFriends(const std::string& username) const;
+    // Mutual friends of 'username' with each of 'others', in the same order;
+    // unknown users get a count of 0
+    std::vector<MutualFriends> getMutualFriendsBatch(const std::string& username, const std::vector<std::string>& others,
+                                                     bool withNames) const;
+    // Best 'limit' friends-of-friends by mutual friends, then interactions;
+    // people with a pending request either way are left out
+    std::vector<std::pair<std::string, uint32_t>> suggestFriends(const std::string& username, size_t limit);
+    // 'actor' reacted to or commented on a post by 'owner'
+    void noteInteraction(const std::string& actor, const std::string& owner);
+
+    // Load both snapshots, replay the edge log ("<friendsFile>.wal") on top
+    // and log every change from then on
+    void open(const std::string& friendsFile, const std::string& pendingFile);
+    // Write fresh snapshots and drop the edge records they cover
+    void compact();
 
-    // Save and load functions
+    // Save and load functions (full JSON snapshots, for import and export)
     void saveFriends(const std::string& filename);
     void loadFriends(const std::string& filename);
     void savePendingRequests(const std::string& filename);
     void loadPendingRequests(const std::string& filename);
 
     int getFriendCount(const std::string& username) const;
+
+    void setFriendshipListener(std::function<void(const std::string&, const std::string&, bool)> listener);
 };
 
 #endif // FRIEND_MANAGER_H
\ No newline at end of file
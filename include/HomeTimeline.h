@@ -0,0 +1,81 @@
+#ifndef HOME_TIMELINE_H
+#define HOME_TIMELINE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <shared_mutex>
+#include <climits>
+
+// Fixed-capacity ring of post ids kept in ascending (= chronological) order.
+// When full, pushing a newer id evicts the oldest one.
+class PostIdRing {
+private:
+    std::vector<int> buffer;
+    size_t capacity;
+    size_t head = 0;  // index of the oldest id
+    size_t count = 0;
+    int dropped = 0;  // highest id evicted for space; every id above it is kept
+
+    int& slot(size_t i) { return buffer[(head + i) % capacity]; }
+    int slot(size_t i) const { return buffer[(head + i) % capacity]; }
+    void assign(const std::vector<int>& ascending);
+
+public:
+    explicit PostIdRing(size_t capacity);
+
+    void push(int postId);
+    void remove(int postId);
+    void removeAll(const std::unordered_set<int>& postIds);
+    // Merge another ring's ids, keeping only the newest 'capacity'. Ids the
+    // other ring dropped are missing here too, so its floor carries over.
+    void merge(const PostIdRing& other);
+    std::vector<int> toVector() const;
+    // Newest first, only ids strictly below 'beforeId'
+    void newest(size_t limit, int beforeId, std::vector<int>& out) const;
+    size_t size() const { return count; }
+    // Ids at or below this may have been dropped; 0 if the ring is complete
+    int floor() const { return dropped; }
+};
+
+// Materialized per-user home timelines (fan-out-on-write).
+//  - Every post is pushed into the inbox of its author and each of the
+//    author's friends, so reading a feed is O(page size).
+//  - Authors with more than 'fanoutLimit' friends are not fanned out;
+//    readers merge those authors' own rings at read time instead
+//    (fan-out-on-read), which bounds the cost of a single post. When such
+//    an author drops back under the limit, their recent posts are pushed
+//    to every friend before fan-out resumes.
+//  - Friendship changes and deletions repair the affected inboxes.
+//  - Rings are bounded, so read() also reports the id at or below which
+//    they may have lost posts; the caller finds older posts elsewhere.
+class HomeTimelines {
+private:
+    size_t capacity;
+    size_t fanoutLimit;
+    std::unordered_map<std::string, PostIdRing> inboxes;
+    std::unordered_map<std::string, PostIdRing> authored;
+    std::unordered_set<std::string> highFanoutAuthors;
+    mutable std::shared_mutex mutex;
+
+    PostIdRing& ring(std::unordered_map<std::string, PostIdRing>& rings, const std::string& user);
+
+public:
+    explicit HomeTimelines(size_t capacity = 500, size_t fanoutLimit = 1000);
+
+    void addPost(const std::string& author, int postId, const std::vector<std::string>& friends);
+    void removePost(const std::string& author, int postId, const std::vector<std::string>& friends);
+    void addFriendship(const std::string& userA, const std::string& userB);
+    void removeFriendship(const std::string& userA, const std::string& userB);
+    void clear();
+
+    // Newest-first post ids for 'username', at most 'limit', all below 'beforeId'
+    // and above 'floor'. Every post in that range is returned (up to 'limit'),
+    // so a short result means the rings hold nothing more above 'floor'.
+    // 'friends' is the reader's sorted friend list (used for the fan-out-on-read authors).
+    std::vector<int> read(const std::string& username, const std::vector<std::string>& friends,
+                          size_t limit, int beforeId, int& floor) const;
+};
+
+#endif // HOME_TIMELINE_H
@@ -0,0 +1,50 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Append-only write-ahead log. Each record is one compact JSON object on its
+// own line, so appending costs O(record) no matter how big the data set is.
+//
+// Compaction is a two step affair driven by the owner:
+//   1. rotate()  - under the owner's lock, the live log is renamed to
+//                  "<path>.old" and a fresh log is opened;
+//   2. the owner writes its snapshot, then calls dropRotated().
+// If we crash in between, replay() reads "<path>.old" before "<path>", so the
+// owner's replay handlers must be idempotent.
+class Journal {
+private:
+    std::string path_;
+    std::ofstream out_;
+    size_t records_ = 0;
+    mutable std::mutex mutex_;
+
+    void open();
+    static size_t replayFile(const std::string& path, const std::function<void(const nlohmann::json&)>& apply);
+
+public:
+    explicit Journal(const std::string& path);
+
+    // Append a single record and flush it to disk
+    void append(const nlohmann::json& record);
+    // Append several records with a single flush
+    void appendBatch(const std::vector<nlohmann::json>& records);
+
+    // Feed every record (rotated log first, then live log) to 'apply'.
+    // A torn last line from a crash mid-append is skipped.
+    size_t replay(const std::function<void(const nlohmann::json&)>& apply);
+
+    void rotate();
+    void dropRotated();
+
+    // Number of records in the live log (replayed + appended since rotate())
+    size_t size() const;
+    const std::string& getPath() const { return path_; }
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,41 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Streaming JSON writer that appends straight to an output string (for
+// example crow::response::body), with no intermediate document tree.
+// Commas are inserted automatically; callers just nest begin/end calls:
+//
+//   JsonWriter w(res.body);
+//   w.beginObject().key("id").value(1).key("tags").beginArray().value("a").endArray().endObject();
+class JsonWriter {
+private:
+    std::string& out;
+    std::vector<bool> needsComma; // one entry per open object/array
+    bool afterKey = false;
+
+    void separator();
+
+public:
+    explicit JsonWriter(std::string& target);
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(std::string_view name);
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(long long number);
+    JsonWriter& value(int number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(long number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(unsigned long number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(bool flag);
+
+    static void appendEscaped(std::string& target, std::string_view text);
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,86 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+
+enum class LogLevel { Debug = 0, Info, Warn, Error, Off };
+
+// Leveled, asynchronous logger.
+//  - Callers format the line and push it into a bounded lock-free ring
+//    (multi-producer, single-consumer); a background thread drains the ring
+//    and writes whole batches to stdout/stderr, so request threads never
+//    wait on the console.
+//  - When the ring is full the line is dropped and counted rather than
+//    blocking the caller; the flusher reports how many were lost.
+//  - The level is an atomic checked by the LOG_* macros before anything is
+//    formatted, so disabled calls cost one relaxed load.
+// The level can be changed at runtime with setLevel(), and is read from
+// the LOG_LEVEL environment variable (debug|info|warn|error|off) on start.
+class Logger {
+private:
+    struct Entry {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
+
+    static const size_t CAPACITY = 16384; // power of two
+
+    std::unique_ptr<Entry[]> ring;
+    std::atomic<size_t> enqueuePos{0};
+    // Flusher thread only
+    size_t dequeuePos = 0;
+    time_t stampSecond = 0;
+    char stamp[32] = {};
+    std::atomic<int> minLevel;
+    std::atomic<size_t> dropped{0};
+    std::atomic<bool> running{true};
+    std::thread flusher;
+
+    Logger();
+    void flushLoop();
+    bool drain(); // returns true if anything was written
+
+public:
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    static Logger& instance();
+    static bool parseLevel(const std::string& name, LogLevel& level);
+
+    void setLevel(LogLevel level) { minLevel.store(static_cast<int>(level), std::memory_order_relaxed); }
+    LogLevel getLevel() const { return static_cast<LogLevel>(minLevel.load(std::memory_order_relaxed)); }
+    bool enabled(LogLevel level) const {
+        return static_cast<int>(level) >= minLevel.load(std::memory_order_relaxed);
+    }
+
+    void log(LogLevel level, std::string message);
+    // Block until everything logged so far has been written
+    void flush();
+};
+
+// Stream-style helpers: LOG_INFO("Loaded " << count << " posts");
+#define LOG_AT(level, expr)                                          \
+    do {                                                             \
+        if (Logger::instance().enabled(level)) {                     \
+            std::ostringstream logStream_;                           \
+            logStream_ << expr;                                      \
+            Logger::instance().log(level, logStream_.str());         \
+        }                                                            \
+    } while (0)
+
+#define LOG_DEBUG(expr) LOG_AT(LogLevel::Debug, expr)
+#define LOG_INFO(expr) LOG_AT(LogLevel::Info, expr)
+#define LOG_WARN(expr) LOG_AT(LogLevel::Warn, expr)
+#define LOG_ERROR(expr) LOG_AT(LogLevel::Error, expr)
+
+#endif // LOGGER_H
@@ -0,0 +1,114 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <memory>
+#include <vector>
+#include <new>
+#include <algorithm>
+#include <cstddef>
+
+// Chunks and free list shared by every copy and rebind of a NodePool
+struct NodePoolArena {
+    static constexpr size_t CHUNK_BYTES = size_t(64) << 10;
+
+    size_t blockSize = 0;
+    std::vector<char*> chunks;
+    char* next = nullptr;
+    char* end = nullptr;
+    void* freeList = nullptr;
+
+    NodePoolArena() = default;
+    NodePoolArena(const NodePoolArena&) = delete;
+    NodePoolArena& operator=(const NodePoolArena&) = delete;
+    ~NodePoolArena() {
+        for (char* chunk : chunks) ::operator delete(chunk);
+    }
+
+    void* allocate() {
+        if (freeList) {
+            void* block = freeList;
+            freeList = *static_cast<void**>(block);
+            return block;
+        }
+        if (next == end) {
+            size_t count = std::max<size_t>(1, CHUNK_BYTES / blockSize);
+            char* chunk = static_cast<char*>(::operator new(count * blockSize));
+            chunks.push_back(chunk);
+            next = chunk;
+            end = chunk + count * blockSize;
+        }
+        void* block = next;
+        next += blockSize;
+        return block;
+    }
+
+    void deallocate(void* block) {
+        *static_cast<void**>(block) = freeList;
+        freeList = block;
+    }
+};
+
+// Standard allocator that hands out single objects from a shared arena.
+//  - Objects are carved out of 64 KiB chunks back to back, so the nodes of
+//    every container sharing the pool sit close together instead of being
+//    scattered over the heap one malloc at a time.
+//  - Freed objects go on an intrusive free list and are reused by the next
+//    allocation; chunks are only returned when the last copy of the pool
+//    (and so the last container using it) is gone.
+//  - Copies and rebinds share one arena. The arena serves one object size,
+//    fixed by the first single-object allocation; anything else (arrays,
+//    other sizes) goes straight to operator new.
+// Not synchronized: containers sharing a pool must be guarded by one lock.
+template <typename T>
+class NodePool {
+private:
+    template <typename U> friend class NodePool;
+
+    std::shared_ptr<NodePoolArena> arena;
+
+    // Blocks are rounded up so every one stays aligned and can hold the free-list link
+    static constexpr size_t blockSizeOf() {
+        constexpr size_t align = alignof(std::max_align_t);
+        constexpr size_t size = sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T);
+        return (size + align - 1) / align * align;
+    }
+    bool pooled(size_t n) const {
+        return n == 1 && alignof(T) <= alignof(std::max_align_t) &&
+               (arena->blockSize == 0 || arena->blockSize == blockSizeOf());
+    }
+
+public:
+    using value_type = T;
+
+    NodePool() : arena(std::make_shared<NodePoolArena>()) {}
+    NodePool(const NodePool& other) : arena(other.arena) {}
+    template <typename U>
+    NodePool(const NodePool<U>& other) : arena(other.arena) {}
+    NodePool& operator=(const NodePool& other) {
+        arena = other.arena;
+        return *this;
+    }
+
+    T* allocate(size_t n) {
+        if (!pooled(n)) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        arena->blockSize = blockSizeOf();
+        return static_cast<T*>(arena->allocate());
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (pooled(n)) {
+            arena->deallocate(p);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const NodePool<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const NodePool<U>& other) const { return arena != other.arena; }
+};
+
+#endif // NODE_POOL_H
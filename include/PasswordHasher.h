@@ -0,0 +1,65 @@
+#ifndef PASSWORD_HASHER_H
+#define PASSWORD_HASHER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+// Thrown when too many hashes are already queued; callers should ask the
+// client to retry rather than wait
+class HasherBusyError : public std::runtime_error {
+public:
+    HasherBusyError() : std::runtime_error("Server is busy, please try again shortly") {}
+};
+
+// Password hashing (PBKDF2-HMAC-SHA256) on a small dedicated thread pool.
+//  - The work factor is deliberately high, so it runs on its own threads
+//    (PASSWORD_HASH_THREADS, default a quarter of the cores) instead of
+//    whichever request thread happened to take the login.
+//  - At most 'maxPending' hashes may be queued or running. Past that,
+//    hash() throws HasherBusyError at once, so a login burst ties up a
+//    bounded number of request threads and the rest keep serving reads.
+// The iteration count for new hashes comes from PASSWORD_ITERATIONS
+// (default 100000); each stored hash records the count it was made with.
+class PasswordHasher {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    size_t pending = 0; // queued + running
+    size_t maxPending;
+    bool stopping = false;
+    uint32_t iterations;
+
+    void workerLoop();
+
+public:
+    // Hashes made before iteration counts were stored: one SHA-256 round
+    static constexpr uint32_t LEGACY = 0;
+    static constexpr uint32_t DEFAULT_ITERATIONS = 100000;
+
+    explicit PasswordHasher(size_t threads = 0);
+    ~PasswordHasher();
+    PasswordHasher(const PasswordHasher&) = delete;
+    PasswordHasher& operator=(const PasswordHasher&) = delete;
+
+    // Hash on a pool thread and wait for the result
+    std::string hash(const std::string& pass, const std::string& salt, uint32_t iterations);
+    // Iteration count for new and upgraded hashes
+    uint32_t currentIterations() const { return iterations; }
+
+    // Hex digest; runs on the calling thread
+    static std::string derive(const std::string& pass, const std::string& salt, uint32_t iterations);
+    // Constant-time comparison of two digests
+    static bool matches(const std::string& a, const std::string& b);
+};
+
+#endif // PASSWORD_HASHER_H
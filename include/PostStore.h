@@ -0,0 +1,93 @@
+#ifndef POST_STORE_H
+#define POST_STORE_H
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstddef>
+
+class Post;
+using PostPtr = std::shared_ptr<Post>;
+
+// Immutable view of the post slots handed out to readers. Slots are split
+// into fixed-size chunks that are shared between snapshots, so publishing
+// after an insert or delete only copies the chunk that changed plus the
+// chunk table. Deleted posts leave an empty (null) slot that iteration skips.
+class PostsView {
+public:
+    static const size_t CHUNK_SIZE = 512;
+    using Chunk = std::vector<PostPtr>;
+
+    class const_iterator {
+        const PostsView* view;
+        size_t slot;
+        void skipEmpty() {
+            while (slot < view->slotCount && !view->at(slot)) slot++;
+        }
+    public:
+        const_iterator(const PostsView* v, size_t s) : view(v), slot(s) { skipEmpty(); }
+        const PostPtr& operator*() const { return view->at(slot); }
+        const PostPtr* operator->() const { return &view->at(slot); }
+        const_iterator& operator++() { slot++; skipEmpty(); return *this; }
+        bool operator!=(const const_iterator& other) const { return slot != other.slot; }
+        bool operator==(const const_iterator& other) const { return slot == other.slot; }
+    };
+
+    PostsView() = default;
+    PostsView(std::vector<std::shared_ptr<const Chunk>> chunks, size_t slots, size_t live)
+        : chunks(std::move(chunks)), slotCount(slots), liveCount(live) {}
+
+    const PostPtr& at(size_t slot) const { return (*chunks[slot / CHUNK_SIZE])[slot % CHUNK_SIZE]; }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, slotCount); }
+    size_t size() const { return liveCount; }
+    bool empty() const { return liveCount == 0; }
+
+private:
+    std::vector<std::shared_ptr<const Chunk>> chunks;
+    size_t slotCount = 0; // including empty slots
+    size_t liveCount = 0;
+};
+
+using PostsSnapshot = std::shared_ptr<const PostsView>;
+
+// Slot storage for posts with an id -> slot index.
+//  - find/erase are O(1); erase only clears the slot (no shifting).
+//  - Posts are handed out as shared_ptr handles, so they stay valid across
+//    inserts, deletes and slot compaction.
+//  - Once empty slots outnumber live posts the slots are compacted (O(n),
+//    amortized O(1) per delete).
+// Writers are expected to be serialized by the owner; find() may run
+// concurrently with them.
+class PostStore {
+private:
+    using Chunk = PostsView::Chunk;
+
+    std::vector<std::shared_ptr<Chunk>> chunks; // writer-side, copy-on-write once published
+    std::unordered_map<int, size_t> slotById;
+    size_t slotCount = 0;
+    PostsSnapshot published;
+    mutable std::shared_mutex mutex; // guards chunks/slotById against find()
+
+    Chunk& writableChunk(size_t chunkIndex);
+    void compactSlots();
+
+public:
+    PostStore();
+
+    PostPtr find(int postId) const;
+    // Adds a post; returns false if the id is already present
+    bool insert(int postId, PostPtr post);
+    // Removes a post and returns it (null if it wasn't there)
+    PostPtr erase(int postId);
+    void clear();
+    size_t size() const;
+
+    // Make the current state visible to snapshot(). Bulk loaders insert
+    // everything first and publish once.
+    void publish();
+    PostsSnapshot snapshot() const { return std::atomic_load(&published); }
+};
+
+#endif // POST_STORE_H
@@ -0,0 +1,82 @@
+#ifndef REACTION_SET_H
+#define REACTION_SET_H
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include "SymbolTable.h"
+
+// Reactions on one post: at most one reaction per user, each with a type
+// from a fixed set ("like", "love", ...). Users and types are interned
+// Symbols.
+//  - Up to INLINE_LIMIT reactions are kept in a small vector sorted by user
+//    id, which is cheaper than a hash table for the typical post.
+//  - Past that the set moves to a hash map user -> type, so toggling a like
+//    on a viral post is O(1) instead of O(likes).
+//  - The total and the per-type counts are maintained on every change.
+// Not synchronized: the owning post's lock guards it.
+class ReactionSet {
+public:
+    static const size_t INLINE_LIMIT = 32;
+
+private:
+    struct Entry {
+        SymbolId user;
+        SymbolId type;
+    };
+
+    std::vector<Entry> small; // sorted by user, used while 'large' is null
+    std::unique_ptr<std::unordered_map<SymbolId, SymbolId>> large;
+    std::vector<std::pair<Symbol, uint32_t>> typeCounts; // few types, first-seen order
+    size_t total = 0;
+
+    std::vector<Entry>::iterator findSmall(SymbolId user);
+    std::vector<Entry>::const_iterator findSmall(SymbolId user) const;
+    void countType(Symbol type, int delta);
+    void promote();
+
+public:
+    // Only these types are accepted from clients, so a request cannot
+    // intern arbitrary strings as reaction types
+    static bool isValidType(std::string_view type);
+
+    ReactionSet() = default;
+    ReactionSet(const ReactionSet& other);
+    ReactionSet& operator=(const ReactionSet& other);
+    ReactionSet(ReactionSet&&) = default;
+    ReactionSet& operator=(ReactionSet&&) = default;
+
+    // Both return false if nothing changed; set() replaces an existing type
+    bool set(Symbol user, Symbol type);
+    bool erase(Symbol user);
+    // Same type again removes the reaction, anything else sets it.
+    // Returns whether the user has a reaction afterwards.
+    bool toggle(Symbol user, Symbol type);
+
+    bool contains(Symbol user) const;
+    // Empty symbol if the user has not reacted
+    Symbol typeOf(Symbol user) const;
+    size_t size() const { return total; }
+    bool empty() const { return total == 0; }
+    size_t count(Symbol type) const;
+    const std::vector<std::pair<Symbol, uint32_t>>& counts() const { return typeCounts; }
+
+    // fn(Symbol user, Symbol type) for every reaction, in no particular order
+    template<typename F>
+    void forEach(F fn) const;
+};
+
+template<typename F>
+void ReactionSet::forEach(F fn) const {
+    if (large) {
+        for (const auto& entry : *large) fn(Symbol::fromId(entry.first), Symbol::fromId(entry.second));
+    } else {
+        for (const Entry& entry : small) fn(Symbol::fromId(entry.user), Symbol::fromId(entry.type));
+    }
+}
+
+#endif // REACTION_SET_H
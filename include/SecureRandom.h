@@ -0,0 +1,28 @@
+#ifndef SECURE_RANDOM_H
+#define SECURE_RANDOM_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Cryptographically secure random bytes, tokens and salts.
+//  - Each thread keeps its own buffer, refilled BUFFER_SIZE bytes at a time
+//    from OpenSSL's CSPRNG (itself seeded from the OS), so a token costs a
+//    memcpy and a table lookup per character, and threads share no lock.
+//  - Text comes out as base64url: every character carries 6 random bits,
+//    3 bytes make 4 characters, no modulo bias.
+// Throws runtime_error if the CSPRNG cannot be read, rather than falling
+// back to something weaker.
+class SecureRandom {
+public:
+    static constexpr size_t BUFFER_SIZE = 4096;
+
+    static void fill(void* out, size_t size);
+    static uint64_t u64();
+
+    // 'length' base64url characters written to 'out' (no terminator)
+    static void token(char* out, size_t length);
+    static std::string token(size_t length);
+};
+
+#endif // SECURE_RANDOM_H
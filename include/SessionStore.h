@@ -0,0 +1,123 @@
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <ctime>
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include "SymbolTable.h"
+#include "Journal.h"
+
+// Login sessions (token -> user), each valid for 'ttl' after login.
+//  - Tokens are spread over SHARDS independently locked shards by hash, so
+//    validating a token is one shared lock on one shard plus one lookup,
+//    and logins or logouts elsewhere never block it.
+//  - Lookups reject expired sessions on their own. Removing them is left to
+//    a background thread driving a timer wheel: every session sits in the
+//    slot of the tick it expires in, so each tick only visits the sessions
+//    hashed to that slot instead of scanning the whole table.
+//  - Logins are queued and appended to a journal ("<path>.wal") in batches
+//    by the same thread, at most 'flushInterval' apart. A logout is written
+//    (with everything queued ahead of it) before close() returns, so a
+//    session that was logged out can't come back after a crash. Once the
+//    journal grows past 'compactThreshold' it is folded back into the JSON
+//    snapshot at "<path>". A crash loses at most the last unwritten batch of
+//    logins; a lost login just means logging in again.
+// The session lifetime can be set with the SESSION_TTL environment variable
+// (in seconds); the default is a week.
+class SessionStore {
+private:
+    struct Session {
+        Symbol user;
+        time_t expires;
+    };
+    struct alignas(64) TokenShard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, Session> sessions;
+    };
+    // Lock order: a user's shard before a token's shard
+    struct alignas(64) UserShard {
+        std::mutex mutex;
+        std::unordered_map<Symbol, std::string> tokens;
+    };
+
+    static constexpr size_t SHARDS = 64; // power of two
+    static constexpr size_t WHEEL_SLOTS = 1024;
+    static constexpr time_t WHEEL_TICK = 60; // seconds per slot
+
+    std::unique_ptr<TokenShard[]> tokenShards;
+    std::unique_ptr<UserShard[]> userShards;
+    time_t ttl;
+
+    // Timer wheel: tokens by the tick they expire in, modulo WHEEL_SLOTS.
+    // A slot holds sessions from several turns of the wheel; the ones not yet
+    // due stay put until the wheel comes round again.
+    std::vector<std::vector<std::string>> wheel;
+    time_t wheelTick = 0; // last tick swept
+    std::mutex wheelMutex;
+
+    // Persistence
+    std::string path;
+    Journal journal;
+    std::vector<nlohmann::json> pending; // records not yet in the journal
+    std::mutex pendingMutex;
+    std::mutex flushMutex; // held from taking a batch to writing it, so batches stay in order
+    std::mutex compactMutex; // one compaction at a time
+    size_t compactThreshold = 1000;
+    std::chrono::milliseconds flushInterval{1000};
+
+    std::thread worker;
+    std::mutex workerMutex;
+    std::condition_variable workerCv;
+    bool stopWorker = false;
+
+    TokenShard& tokenShard(const std::string& token) const;
+    UserShard& userShard(Symbol user) const;
+
+    // Apply a change to the table (no journaling)
+    void insert(const std::string& token, Symbol user, time_t expires);
+    bool erase(const std::string& token, Symbol& user);
+    void schedule(const std::string& token, time_t expires);
+    void queue(nlohmann::json record);
+
+    void workerLoop();
+    void sweep(time_t now);
+    void loadSnapshot();
+    void applyRecord(const nlohmann::json& record, time_t now);
+
+public:
+    explicit SessionStore(const std::string& path);
+    ~SessionStore();
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+
+    // Load the snapshot, replay the journal and start the background thread
+    void load();
+
+    // The user's live session, or a new one with a token from 'newToken'
+    std::string open(Symbol user, const std::function<std::string()>& newToken);
+    // Ends the session; false if there was none
+    bool close(const std::string& token);
+    // The user behind a live session
+    bool find(const std::string& token, Symbol& user) const;
+    bool contains(const std::string& token) const;
+
+    // Append queued changes to the journal now
+    void flush();
+    // Write the snapshot and start a fresh journal
+    void compact();
+
+    size_t size() const;
+    std::chrono::seconds getTtl() const { return std::chrono::seconds(ttl); }
+};
+
+#endif // SESSION_STORE_H
@@ -0,0 +1,91 @@
+#ifndef SIGNED_TOKENS_H
+#define SIGNED_TOKENS_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <cstdint>
+#include <cstddef>
+
+// Stateless session tokens: "<payload>.<signature>", both base64url.
+//  - The payload carries the username, issue time, expiry and a random
+//    64-bit token id; the signature is HMAC-SHA256 over it. Checking a
+//    token needs only the key, so any server process sharing the key
+//    accepts tokens issued by any other, with no session table to consult.
+//  - The key comes from the SESSION_SECRET environment variable when set,
+//    otherwise from a 32-byte key file created on first use (safe when
+//    several processes start at once: the first to link its file wins).
+//  - Logout adds the token id to a revocation list. Revocations are
+//    appended to a shared file that a background thread tails, so every
+//    process sees a logout within about a second. Entries are dropped from
+//    memory once the token would have expired anyway, and once most lines
+//    in the file are expired it is rewritten with only the live ones. The
+//    rewrite holds an exclusive flock on the file; appenders take a shared
+//    one and follow the file to its new inode after a rewrite, so no
+//    process appends to a file that has already been replaced.
+class SignedTokens {
+private:
+    static constexpr size_t KEY_SIZE = 32;
+    static constexpr size_t SIGNATURE_SIZE = 32; // SHA-256
+    static constexpr uint8_t VERSION = 1;
+
+    unsigned char key[KEY_SIZE];
+    time_t ttl;
+
+    // Revoked token id -> when the token expires
+    std::unordered_map<uint64_t, time_t> revoked;
+    mutable std::shared_mutex revokedMutex;
+    std::atomic<size_t> revokedCount{0}; // lets verify() skip the lock when empty
+    std::string revokedPath;
+    int revokedFd = -1; // append-only, guarded by fileMutex
+    std::mutex fileMutex;
+    // How far the file has been read, and what it was (worker only)
+    uint64_t readOffset = 0;
+    uint64_t readInode = 0;
+    size_t linesRead = 0;
+    static constexpr size_t MIN_COMPACT_LINES = 1024;
+    std::chrono::milliseconds refreshInterval{1000};
+
+    std::thread worker;
+    std::mutex workerMutex;
+    std::condition_variable workerCv;
+    bool stopWorker = false;
+
+    void loadKey(const std::string& keyPath);
+    void sign(std::string_view payload, unsigned char* out) const;
+    // Payload fields of a well-signed token
+    bool decode(std::string_view token, std::string& user, uint64_t& id, time_t& expires) const;
+    void addRevoked(uint64_t id, time_t expires);
+    void readRevocations(); // new lines appended by any process
+    bool appendRevocation(const char* line, size_t size);
+    bool followReplacedFile(); // reopen revokedFd if the file was replaced
+    void compactRevocations();
+    void workerLoop();
+
+public:
+    SignedTokens(const std::string& keyPath, const std::string& revokedPath, std::chrono::seconds ttl);
+    ~SignedTokens();
+    SignedTokens(const SignedTokens&) = delete;
+    SignedTokens& operator=(const SignedTokens&) = delete;
+
+    std::string issue(const std::string& user) const;
+    // Signature, expiry and revocation; sets 'user' when valid
+    bool verify(std::string_view token, std::string& user) const;
+    // False if the token was not valid to begin with
+    bool revoke(std::string_view token);
+
+    // Signed tokens contain a '.', table tokens never do
+    static bool looksSigned(std::string_view token) { return token.find('.') != std::string_view::npos; }
+
+    static std::string base64url(const unsigned char* data, size_t size);
+    static bool unbase64url(std::string_view text, std::string& out);
+};
+
+#endif // SIGNED_TOKENS_H
@@ -0,0 +1,108 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "SymbolTable.h"
+
+// Binary snapshot files, the fast-start alternative to the JSON snapshots.
+//
+// Layout (integers are stored in host byte order, i.e. little-endian on
+// every platform we run on):
+//   header   magic "CS2SNAP", format version, kind tag, payload size and a
+//            CRC-32 of the payload
+//   payload  symbol table (every username / reaction type used below,
+//            once), then the owner's records
+// Records refer to names by their index in the symbol table, so each name
+// is interned exactly once on load no matter how often it appears.
+//
+// Files are written next to the old one, synced and renamed into place
+// (see snapshot::replaceFile), and read
+// through a read-only memory mapping: strings are handed out as views into
+// the mapping, so loading is a linear walk with no parser in between.
+class SnapshotWriter {
+private:
+    std::string payload;
+    std::vector<SymbolId> symbols;
+    std::unordered_map<SymbolId, uint32_t> symbolIndex;
+
+    void raw(const void* data, size_t size) { payload.append(static_cast<const char*>(data), size); }
+
+public:
+    void u32(uint32_t value) { raw(&value, sizeof(value)); }
+    void i32(int32_t value) { raw(&value, sizeof(value)); }
+    void u64(uint64_t value) { raw(&value, sizeof(value)); }
+    void i64(int64_t value) { raw(&value, sizeof(value)); }
+    void str(std::string_view text);
+    void symbol(Symbol name);
+
+    // Write header + symbol table + payload to 'path' atomically
+    void save(const std::string& path, uint32_t kind) const;
+};
+
+class SnapshotReader {
+private:
+    const char* base = nullptr;
+    size_t mappedSize = 0;
+    const char* pos = nullptr;
+    const char* end = nullptr;
+    std::vector<Symbol> symbols;
+    std::string path_;
+    uint32_t version_ = 0;
+
+    const char* take(size_t size);
+    template<typename T>
+    T read() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+public:
+    // Maps and validates the file; throws runtime_error if it is missing,
+    // of another kind or version, or fails the checksum
+    SnapshotReader(const std::string& path, uint32_t kind);
+    ~SnapshotReader();
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    uint32_t u32() { return read<uint32_t>(); }
+    int32_t i32() { return read<int32_t>(); }
+    uint64_t u64() { return read<uint64_t>(); }
+    int64_t i64() { return read<int64_t>(); }
+    // View into the mapping, valid until the reader is destroyed
+    std::string_view str();
+    Symbol symbol();
+    bool done() const { return pos == end; }
+    size_t fileSize() const { return mappedSize; }
+    uint32_t version() const { return version_; }
+};
+
+namespace snapshot {
+    // Written by SnapshotWriter; readers accept MIN_VERSION..VERSION and
+    // owners check SnapshotReader::version() for fields added since
+    //   2: users carry a password iteration count
+    const uint32_t VERSION = 2;
+    const uint32_t MIN_VERSION = 1;
+    // Kind tags, so a file can't be loaded by the wrong owner
+    const uint32_t POSTS = 0x54534f50;   // "POST"
+    const uint32_t FRIENDS = 0x444e5246; // "FRND"
+    const uint32_t USERS = 0x52455355;   // "USER"
+
+    uint32_t crc32(const char* data, size_t size, uint32_t crc = 0);
+    // "<dir>/posts.json" -> "<dir>/posts.bin"
+    std::string binaryPath(const std::string& jsonPath);
+    // Write 'parts' to "<path>.tmp", fsync it, rename it over 'path' and
+    // fsync the directory, so once this returns the new file survives a
+    // crash and the journal it replaces can be dropped. Throws
+    // runtime_error; 'path' is left untouched on failure.
+    void replaceFile(const std::string& path, std::initializer_list<std::string_view> parts);
+}
+
+#endif // SNAPSHOT_H
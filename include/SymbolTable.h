@@ -0,0 +1,81 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+using SymbolId = uint32_t;
+
+// Process-wide interned strings (usernames). Each distinct name is stored
+// once and handed out as a dense 32-bit id, so the subsystems that keep
+// names around (posts, comments, reactions, friend graph, pending requests,
+// sessions, search) hold 4-byte ids and compare them as integers.
+//  - Names live in fixed-size blocks that are never moved or freed, so
+//    name(id) is a lock-free lookup returning a stable reference.
+//  - intern() takes a shared lock for the common "already known" case and
+//    a unique lock only to add a new name.
+// Id 0 is the empty string.
+class SymbolTable {
+private:
+    static constexpr size_t BLOCK_BITS = 12;
+    static constexpr size_t BLOCK_SIZE = size_t(1) << BLOCK_BITS;
+    static constexpr size_t MAX_BLOCKS = size_t(1) << 16; // 268M names
+
+    std::unique_ptr<std::atomic<std::string*>[]> blocks;
+    std::unordered_map<std::string_view, SymbolId> ids; // views into the blocks
+    std::atomic<size_t> count{0};
+    mutable std::shared_mutex mutex;
+
+    SymbolTable();
+
+public:
+    ~SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    static SymbolTable& global();
+
+    SymbolId intern(std::string_view text);
+    // Look up without adding
+    bool find(std::string_view text, SymbolId& id) const;
+    const std::string& name(SymbolId id) const {
+        return blocks[id >> BLOCK_BITS].load(std::memory_order_acquire)[id & (BLOCK_SIZE - 1)];
+    }
+    size_t size() const { return count.load(std::memory_order_acquire); }
+};
+
+// Value handle for an interned name: 4 bytes, integer equality and hashing.
+class Symbol {
+private:
+    SymbolId id_ = 0;
+
+public:
+    Symbol() = default;
+    explicit Symbol(std::string_view text) : id_(SymbolTable::global().intern(text)) {}
+    static Symbol fromId(SymbolId id) { Symbol s; s.id_ = id; return s; }
+
+    SymbolId id() const { return id_; }
+    const std::string& str() const { return SymbolTable::global().name(id_); }
+    bool empty() const { return id_ == 0; }
+
+    bool operator==(const Symbol& other) const { return id_ == other.id_; }
+    bool operator!=(const Symbol& other) const { return id_ != other.id_; }
+    // Orders by id (insertion order), not alphabetically
+    bool operator<(const Symbol& other) const { return id_ < other.id_; }
+};
+
+namespace std {
+template<>
+struct hash<Symbol> {
+    size_t operator()(const Symbol& symbol) const noexcept { return std::hash<SymbolId>()(symbol.id()); }
+};
+}
+
+#endif // SYMBOL_TABLE_H
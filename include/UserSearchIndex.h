@@ -0,0 +1,59 @@
+#ifndef USER_SEARCH_INDEX_H
+#define USER_SEARCH_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <shared_mutex>
+#include <unordered_map>
+#include "SymbolTable.h"
+
+// Case-insensitive username index for the search box.
+//  - Each name is case-folded once on insert and kept next to the interned
+//    original, under a dense id (insertion order).
+//  - 'sorted' holds the ids ordered by folded name, so a prefix query is a
+//    lower_bound plus a scan over the matches: O(log n + |prefix| + results).
+//  - New signups go into the small, also sorted, 'pending' run, which is
+//    merged into 'sorted' once it grows past PENDING_LIMIT. Queries merge
+//    both runs, so inserts stay cheap without giving up ordered results.
+//  - Substring search uses a trigram inverted index over the folded names:
+//    the posting lists of the query's trigrams are intersected (smallest
+//    first), the survivors are verified with a plain find(), then ranked.
+//    Queries shorter than a trigram fall back to a scan.
+// Names that differ only by case are treated as the same user.
+class UserSearchIndex {
+private:
+    static const size_t PENDING_LIMIT = 4096;
+
+    std::vector<Symbol> names;       // by id, as the user typed it
+    std::vector<std::string> folded; // by id, lowercase
+    std::vector<uint32_t> sorted;
+    std::vector<uint32_t> pending;
+    // trigram (3 folded bytes packed into an int) -> ascending ids containing it
+    std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams;
+    mutable std::shared_mutex mutex;
+
+    bool containsLocked(const std::string& foldedName) const;
+    void mergePending();
+    void indexTrigrams(uint32_t id);
+    std::vector<uint32_t> substringCandidates(const std::string& key) const;
+
+public:
+    static std::string fold(const std::string& text);
+
+    void insertUser(const std::string& username);
+    // Bulk load: sorts once instead of inserting one by one
+    void rebuildFromUsers(const std::vector<std::string>& users);
+    void clear();
+
+    // Matching usernames in case-insensitive alphabetical order, at most 'limit'
+    std::vector<std::string> searchByPrefix(const std::string& prefix, size_t limit = SIZE_MAX) const;
+    // Ranked: exact match, then prefix matches, then earlier and shorter matches
+    std::vector<std::string> searchBySubstring(const std::string& query, size_t limit = SIZE_MAX) const;
+    std::vector<std::string> getAllUsers() const;
+    bool userExists(const std::string& username) const;
+    size_t size() const;
+};
+
+#endif // USER_SEARCH_INDEX_H
@@ -2,7 +2,6 @@
 #define USERS_H
 #include <bits/stdc++.h>
 #include <nlohmann/json.hpp>
-#include "AVLTree.h"
 
 using namespace std;
 class BaseUser
@@ -18,10 +17,10 @@ class User: public BaseUser
     // vector<Post> posts;
     string hashedPass;
     string salt;
-    AVLTree<string> friends;
+    uint32_t iterations; // PBKDF2 rounds; 0 = legacy single SHA-256
     public:
     User();
-    User(const string& name, const string& pass, const string& s); 
+    User(const string& name, const string& pass, const string& s, uint32_t iterations = 0);
     bool verifyPass(const string& pass) const;
     // void addPost(string content) const override{};
     // void displayProfile() const override{};
@@ -29,8 +28,7 @@ class User: public BaseUser
     string getUsername() const override;
     string getPass() const;
     string getSalt() const;
-    const AVLTree<string>& getFriendTree() const;
-    AVLTree<string>& getFriendTree();
+    uint32_t getIterations() const { return iterations; }
     
     // JSON serialization methods
     nlohmann::json toJson() const;
@@ -50,5 +48,8 @@ class UserStorage
 public:
     static void saveUsers(const unordered_map<string, User>& users, const string& filename);
     static unordered_map<string, User> loadUsers(const string& filename);
+    // Binary snapshot (see Snapshot.h); loadUsersBinary throws if it is unreadable
+    static void saveUsersBinary(const unordered_map<string, User>& users, const string& filename);
+    static unordered_map<string, User> loadUsersBinary(const string& filename);
 };
 #endif
\ No newline at end of file
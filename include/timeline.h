@@ -4,94 +4,192 @@
 #include <fstream>
 #include <ctime>
 #include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 #include "FriendsManager.h"
+#include "AVLTree.h"
+#include "NodePool.h"
+#include "Journal.h"
+#include "PostStore.h"
+#include "HomeTimeline.h"
+#include "SymbolTable.h"
+#include "ReactionSet.h"
+#include "CommentStore.h"
+#include "Snapshot.h"
 using namespace std;
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
 //-----------------------------------------------------------------
-//Post and comment classes
+//Post class (comments live in CommentStore)
 //-----------------------------------------------------------------
-class Comment {
-    int commentId;
-    int postId;
-    string owner;
-    string content;
-    time_t timestamp;
-public:
-    Comment(int id, int pId, const string& o, const string& c);
-    int getCommentId() const;
-    void setContent(const string& c);
-    void setTimestamp(time_t newTime);
-    string getCommentContent() const;
-    string getCommentOwner() const;
-    time_t getCommentTimes() const;
-    int getPostId() const { return postId; }
-    json CommentToJson() const;
-    static Comment CommentFromJson(const json& Json);
-};
-
-
 class Post{
 private:
     int id;
-    string content;
-    string owner;
+    TextRef content; // text in the ContentHeap
+    Symbol owner; // interned username
     time_t timestamp;
-    vector <Comment> commentVec;
+    // Only a summary of the thread; the comments themselves are in CommentStore
+    size_t commentCount = 0;
+    vector<Comment> commentPreview; // newest COMMENT_PREVIEW, oldest first
     int nextCommentId=1;
-    vector<string> reactions; // Store usernames who liked the post
+    ReactionSet reactions;
+
+    Post(int id, string_view content, Symbol owner, time_t timestamp);
 public:
+    static const size_t COMMENT_PREVIEW = 3;
+
     Post(int id, const string& content, const string& owner);
 
     int getPostId() const;
-    string getPostContent() const;
-    string getPostOwner() const;
+    string_view getPostContent() const;
+    TextRef getContentRef() const { return content; }
+    const string& getPostOwner() const;
     time_t getPostTimes() const;
     json PostToJson() const;
     static Post fromJson(const json& j);
-    void Edit(const string& newContent);
+    // Binary snapshot record (comments are written by PostsManager)
+    void writeBinary(SnapshotWriter& out) const;
+    static Post readBinary(SnapshotReader& in);
+    void Edit(string_view newContent);
 //------------------------------------------------------------
     //funcs to manage comments
     void setNextCommentId(int nextId) { nextCommentId = nextId; }
-    void AddComment(const string& comment, const string& username);
-        void EditComment(const string& newComment, const string& username, int commentId);
-        void deleteComment(const string& username, int commentId);
-    const vector <Comment>& getComments () const;
+    int takeCommentId() { return nextCommentId++; }
+    // Keep nextCommentId past an id seen on replay
+    void noteCommentId(int commentId) { nextCommentId = max(nextCommentId, commentId + 1); }
+    void setCommentSummary(size_t count, vector<Comment> preview);
+    size_t getCommentCount() const { return commentCount; }
+    const vector<Comment>& getCommentPreview() const { return commentPreview; }
     int getNextCommentId() const { return nextCommentId; }
     //--------------------------------------
     // funcs to manage reactions
-    void addReaction(const string& username);
+    // 'type' defaults to the only type the UI sends today
+    void addReaction(const string& username, const string& type = "like");
     void removeReaction(const string& username);
+    // Returns whether the user has a reaction afterwards
+    bool toggleReaction(const string& username, const string& type = "like");
     bool hasReaction(const string& username) const;
     int getReactionCount() const;
-    const vector<string>& getReactions() const;
+    const ReactionSet& getReactions() const;
     //--------------------------------------
 
 };
 
+//-----------------------------------------------------------------
+// Feed ordering and cursors
+//-----------------------------------------------------------------
+
+// Key of the time-ordered post index: newest = largest
+struct PostKey {
+    time_t timestamp;
+    int id;
+    bool operator<(const PostKey& o) const { return timestamp != o.timestamp ? timestamp < o.timestamp : id < o.id; }
+    bool operator>(const PostKey& o) const { return o < *this; }
+    bool operator==(const PostKey& o) const { return timestamp == o.timestamp && id == o.id; }
+};
+
+// Position in a newest-first feed; a page holds the posts strictly older
+// than the cursor. Clients only ever see the encoded (opaque) form.
+struct FeedCursor {
+    PostKey position{numeric_limits<time_t>::max(), INT_MAX}; // default: start from the newest post
+    string encode() const;
+    static bool decode(const string& text, FeedCursor& cursor);
+};
+
 //-----------------------------------------------------------------
 // Posts manager class
 //-----------------------------------------------------------------
 
+// Concurrency model:
+//  - Readers (feeds, search) grab an immutable, reference-counted snapshot of
+//    the post list with getSnapshot(); it is published atomically, so reading
+//    it never takes a lock and stays valid for as long as the caller holds it.
+//  - Each post (with its comments and reactions) is its own aggregate. Writers
+//    serialize on the post's lock from postLock(); readers hold it shared
+//    while they look inside a post or its comment thread.
+//  - Adding/removing posts is serialized on postsMutex, which republishes the
+//    snapshot.
+
 class PostsManager {
 protected:
-    string filePath;
-    vector<Post> PostsVec;
+    string filePath;     // JSON snapshot: imported when there is no binary one
+    string snapshotPath; // binary snapshot, written by compaction
+    PostStore posts; // id -> slot index; writers hold postsMutex
+    CommentStore comments; // threads by post id, under the post's lock
+    // Time-ordered indexes for paging, overall and per author (guarded by
+    // indexMutex). All their nodes come from one pool, declared first so it
+    // outlives the trees.
+    using PostIndex = AVLTree<PostKey, NodePool<PostKey>>;
+    NodePool<PostKey> indexPool;
+    PostIndex timeIndex{indexPool};
+    unordered_map<string, PostIndex> authorIndex;
+    mutable shared_mutex indexMutex;
     int nextPostId = 1;
     json posts_data;
+    mutable array<shared_mutex, 64> postLocks;
+
+    // Every mutation is appended to the journal; posts.json is only rewritten
+    // by compaction (savePosts), which runs in the background once enough
+    // records have piled up.
+    Journal journal;
+    mutable mutex postsMutex;
+    mutex compactMutex;
+    size_t compactThreshold = 1000;
+    chrono::seconds compactInterval{30};
+    thread compactor;
+    condition_variable compactorCv;
+    bool stopCompactor = false;
+
+    void applyRecord(const json& record);
+    void loadComments(Post& post, const json& post_json);
+    // Both fill the store and hand back the posts they added, for buildIndexes
+    void loadJson(const json& data, vector<PostPtr>& loaded);
+    void loadBinary(vector<PostPtr>& loaded);
+    // Re-derive the post's comment count and preview from its thread
+    void refreshCommentSummary(Post& post);
+    void compactorLoop();
+    // Replace both indexes with ones over 'loaded' (sorted in place)
+    void buildIndexes(vector<PostPtr>& loaded);
+    void indexPost(const Post& post);
+    void unindexPost(const Post& post);
+    // Called after a post is created/deleted through the API (not on replay)
+    virtual void onPostAdded(const Post&) {}
+    virtual void onPostRemoved(const Post&) {}
 public:
     PostsManager(const string& file); 
+    virtual ~PostsManager();
     void loadPosts();
-    void savePosts(); 
+    void savePosts(); // writes a full (binary) snapshot and truncates the journal
+    // JSON snapshot in the posts.json format; loadPosts imports it when no
+    // binary snapshot exists
+    void exportJson(const string& path) const;
     //--------------------------------------
     //funcs to manage posts
     void Add_post(const string& post, const string& username);
     void EditPost(int id, string& username, const string& newContent);
     void deletePost(int id);
-    vector<Post>& getPost();
-    Post* findPost(int postId);
+    //funcs to manage comments (journaled)
+    void addComment(int postId, const string& comment, const string& username);
+    void editComment(int postId, int commentId, const string& username, const string& newComment);
+    void deleteComment(int postId, int commentId, const string& username);
+    // Oldest-first page of a post's comments with ids above 'afterId'
+    vector<Comment> getComments(int postId, int afterId, size_t limit, bool& hasMore) const;
+    // Direct access for readers that already hold the post's lock
+    const CommentStore& getCommentStore() const { return comments; }
+    PostsSnapshot getSnapshot() const { return posts.snapshot(); }
+    shared_mutex& postLock(int postId) const { return postLocks[postId % postLocks.size()]; }
+    PostPtr findPost(int postId) const;
+    // Newest-first page of posts older than 'cursor', optionally by one author.
+    // 'hasMore' tells whether another page follows.
+    vector<PostPtr> getPage(size_t limit, const FeedCursor& cursor, bool& hasMore, const string& author = "") const;
+    // Newest-first posts by any of 'authors' strictly older than 'before', at
+    // most 'limit': a k-way merge over their author indexes, O((authors + limit) log n)
+    vector<PostPtr> getAuthorsPage(const vector<string>& authors, size_t limit, const PostKey& before) const;
     int getNextPostId() const { return nextPostId; }
     void setNextPostId(int nextId) { nextPostId = nextId; }
     //--------------------------------------
@@ -100,10 +198,27 @@ public:
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 class Timeline : public PostsManager {
+    HomeTimelines homeTimelines;
+    const FriendsManager* friendsManager = nullptr;
+    vector<string> friendsOf(const string& username) const;
+protected:
+    void onPostAdded(const Post& post) override;
+    void onPostRemoved(const Post& post) override;
 public:
     Timeline(const string& file = "../database/posts.json") : PostsManager(file) {}
     void sortByTime();
     void showComments(int postId) const;
-    void addReaction(int postId, const string& username, const string& reaction);
-    vector<Post> getFilteredPosts(const string& username, const FriendsManager& friendsManager);
+    // Toggles the user's reaction; true if they have one afterwards
+    bool addReaction(int postId, const string& username, const string& reaction);
+    // Every post by the user and their friends, newest first
+    vector<Post> getFilteredPosts(const string& username);
+
+    // Home timelines: attachFriends builds them from the loaded posts, and
+    // onFriendshipChanged must be wired to FriendsManager's listener
+    void attachFriends(const FriendsManager& friends);
+    void onFriendshipChanged(const string& userA, const string& userB, bool added);
+    // Newest-first posts by the user and their friends, older than 'before'.
+    // Served from the home timeline; past what its rings hold, from the
+    // author indexes, so every such post can be reached.
+    vector<PostPtr> getHomeFeed(const string& username, size_t limit, const PostKey& before = FeedCursor().position) const;
 };
\ No newline at end of file
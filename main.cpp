@@ -2,10 +2,13 @@
 #include "include/Users.h"
 #include "include/timeline.h"
 #include "include/FriendsManager.h"
-#include "include/UserSearchBST.h"
+#include "include/UserSearchIndex.h"
+#include "include/JsonWriter.h"
+#include "include/Logger.h"
 #include <crow.h>
 #include <cstdlib>
 #include <ctime>
+#include <chrono>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
@@ -28,6 +31,7 @@ void add_cors_headers(crow::response& res, const crow::request& req) {
     
     res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
     res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization, Accept");
+    res.set_header("Access-Control-Expose-Headers", "X-Next-Cursor");
     res.set_header("Access-Control-Allow-Credentials", "true");
     res.set_header("Access-Control-Max-Age", "3600");
     res.set_header("Vary", "Origin");
@@ -36,7 +40,7 @@ void add_cors_headers(crow::response& res, const crow::request& req) {
 // Helper function to read file content
 std::string readFile(const fs::path& project_root, const std::string& relative_path) {
     fs::path file_path = project_root / relative_path;
-    std::cout << "Reading file: " << file_path << std::endl;
+    LOG_DEBUG("Reading file: " << file_path);
 
     if (fs::exists(file_path)) {
         std::ifstream file(file_path);
@@ -47,7 +51,7 @@ std::string readFile(const fs::path& project_root, const std::string& relative_p
         }
     }
 
-    std::cerr << "Failed to open file: " << file_path << std::endl;
+    LOG_WARN("Failed to open file: " << file_path);
     return "";
 }
 
@@ -67,6 +71,13 @@ crow::response makeJsonResponse(const crow::request& req, int code, const std::s
     return res;
 }
 
+// 503 for when password hashing is saturated; the client should retry
+crow::response makeBusyResponse(const crow::request& req, const std::string& message) {
+    auto res = makeJsonResponse(req, 503, message, true);
+    res.set_header("Retry-After", "1");
+    return res;
+}
+
 // Helper function to find the project root by looking for a marker file (e.g., CMakeLists.txt)
 fs::path find_project_root(fs::path start_path) {
     fs::path current_path = fs::absolute(start_path);
@@ -88,66 +99,232 @@ std::string getTokenFromRequest(const crow::request& req) {
     return authHeader.substr(7);
 }
 
+// Paging and comment options shared by the feed routes:
+//   ?limit=N&cursor=<opaque>        page of N posts older than the cursor
+//   ?include=comments&comments_limit=N   latest N comments per post
+// Without 'limit' the whole feed is returned (the friends feed reads past
+// its home-timeline rings from the author indexes) and without 'include' /
+// 'comments_limit' every comment is inlined, as older clients expect.
+// Every post carries 'comment_count' either way; longer threads are paged
+// through /api/posts/<id>/comments.
+struct FeedOptions {
+    size_t limit = SIZE_MAX;
+    FeedCursor cursor;
+    int commentsLimit = -1; // -1: full comment threads
+};
+
+const size_t MAX_FEED_PAGE = 500;
+const int DEFAULT_COMMENTS_PREVIEW = Post::COMMENT_PREVIEW;
+const size_t DEFAULT_COMMENTS_PAGE = 20;
+const size_t MAX_COMMENTS_PAGE = 100;
+const size_t DEFAULT_SUGGESTIONS = 20;
+const size_t MAX_MUTUAL_BATCH = 200;
+const size_t MAX_FRIENDS_PAGE = 500;
+
+bool parseFeedOptions(const crow::request& req, FeedOptions& options) {
+    try {
+        if (const char* limit = req.url_params.get("limit")) {
+            int value = std::stoi(limit);
+            if (value <= 0) return false;
+            options.limit = std::min<size_t>(value, MAX_FEED_PAGE);
+        }
+        if (const char* cursor = req.url_params.get("cursor")) {
+            if (!FeedCursor::decode(cursor, options.cursor)) return false;
+        }
+        const char* include = req.url_params.get("include");
+        const char* commentsLimit = req.url_params.get("comments_limit");
+        if (include) {
+            bool wantsComments = std::string(include).find("comments") != std::string::npos;
+            options.commentsLimit = wantsComments ? DEFAULT_COMMENTS_PREVIEW : 0;
+        }
+        if (commentsLimit) {
+            options.commentsLimit = std::max(0, std::stoi(commentsLimit));
+        }
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Tell the client where the next page starts, if there is one
+void setNextCursor(crow::response& res, const std::vector<PostPtr>& page, bool hasMore) {
+    if (!hasMore || page.empty()) return;
+    FeedCursor next;
+    next.position = PostKey{page.back()->getPostTimes(), page.back()->getPostId()};
+    res.set_header("X-Next-Cursor", next.encode());
+}
+
+// Wall time of each startup phase, logged as one summary line
+class StartupTimer {
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last = started;
+    std::ostringstream phases;
+
+    static long long millis(std::chrono::steady_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+    }
+public:
+    void lap(const char* phase) {
+        auto now = std::chrono::steady_clock::now();
+        phases << phase << " " << millis(now - last) << " ms, ";
+        last = now;
+    }
+    std::string summary() const {
+        return phases.str() + "total " + std::to_string(millis(std::chrono::steady_clock::now() - started)) + " ms";
+    }
+};
+
+void writeComment(JsonWriter& json, const Comment& comment) {
+    json.beginObject();
+    json.key("id").value(comment.getCommentId());
+    json.key("content").value(comment.getCommentContent());
+    json.key("owner").value(comment.getCommentOwner());
+    json.key("timestamp").value(static_cast<long long>(comment.getCommentTimes()));
+    json.endObject();
+}
+
+// Serialize a feed page straight into 'out' (the response body). Posts are
+// written one at a time under their own lock, so no JSON tree is built and
+// the only copy of each string is the escaped one in the body.
+void writeFeed(std::string& out, const Timeline& timeline, const std::vector<PostPtr>& posts, const FeedOptions& options) {
+    out.reserve(out.size() + posts.size() * 256);
+    JsonWriter json(out);
+    json.beginArray();
+
+    for (const auto& postPtr : posts) {
+        std::shared_lock<std::shared_mutex> postLock(timeline.postLock(postPtr->getPostId()));
+        const Post& post = *postPtr;
+
+        json.beginObject();
+        json.key("id").value(post.getPostId());
+        json.key("content").value(post.getPostContent());
+        json.key("owner").value(post.getPostOwner());
+        json.key("timestamp").value(static_cast<long long>(post.getPostTimes()));
+
+        // Flat list of who reacted (what the UI reads) plus the counts per type
+        const ReactionSet& reactions = post.getReactions();
+        json.key("reactions").beginArray();
+        reactions.forEach([&json](Symbol user, Symbol) { json.value(user.str()); });
+        json.endArray();
+        json.key("reactionCounts").beginObject();
+        for (const auto& typeCount : reactions.counts()) {
+            json.key(typeCount.first.str()).value(static_cast<long long>(typeCount.second));
+        }
+        json.endObject();
+
+        // Previews come from the post itself; only full threads or longer
+        // previews touch the comment store
+        json.key("comments").beginArray();
+        if (options.commentsLimit < 0) {
+            timeline.getCommentStore().forEach(post.getPostId(), [&json](const Comment& comment) { writeComment(json, comment); });
+        } else if (static_cast<size_t>(options.commentsLimit) <= Post::COMMENT_PREVIEW) {
+            const auto& preview = post.getCommentPreview();
+            size_t shown = std::min<size_t>(preview.size(), options.commentsLimit);
+            for (size_t comment_idx = preview.size() - shown; comment_idx < preview.size(); comment_idx++) {
+                writeComment(json, preview[comment_idx]);
+            }
+        } else {
+            for (const Comment& comment : timeline.getCommentStore().latest(post.getPostId(), options.commentsLimit)) {
+                writeComment(json, comment);
+            }
+        }
+        json.endArray();
+        json.key("comment_count").value(post.getCommentCount());
+        json.endObject();
+    }
+    json.endArray();
+}
+
 int main(int argc, char* argv[]) {
-    srand(time(0));
     crow::SimpleApp app;
+    // --export-json: load everything, write the JSON snapshots and exit
+    bool exportJson = argc > 1 && std::string(argv[1]) == "--export-json";
 
     // Determine the executable's path to locate the database directory
     fs::path executable_path(argv[0]);
     fs::path project_root = find_project_root(executable_path.parent_path());
     if (project_root.empty()) {
-        std::cerr << "Error: Could not find project root. Make sure CMakeLists.txt is present." << std::endl;
+        LOG_ERROR("Could not find project root. Make sure CMakeLists.txt is present.");
         return 1;
     }
-    std::cout << "Executable path: " << fs::absolute(executable_path) << std::endl;
-    std::cout << "Project root: " << project_root << std::endl;
+    LOG_INFO("Executable path: " << fs::absolute(executable_path));
+    LOG_INFO("Project root: " << project_root);
     fs::path db_path = project_root / "database";
     fs::path users_db_path = db_path / "users.json";
     fs::path posts_db_path = db_path / "posts.json";
     fs::path friends_db_path = db_path / "friends.json";
     fs::path pending_requests_db_path = db_path / "pending_requests.json";
 
+    // Each subsystem loads its binary snapshot (<name>.bin) when there is
+    // one and imports the JSON file otherwise
+    StartupTimer startup;
+
     // Initialize Authentication
     std::unique_ptr<Authentication> auth;
     try {
         auth = std::make_unique<Authentication>(users_db_path.string());
-        std::cout << "Authentication system initialized successfully" << std::endl;
+        startup.lap("users");
+        LOG_INFO("Authentication system initialized successfully");
     } catch (const std::exception& e) {
-        std::cerr << "Failed to initialize authentication system: " << e.what() << std::endl;
+        LOG_ERROR("Failed to initialize authentication system: " << e.what());
         return 1;
     }
 
     // Initialize Timeline
     Timeline timeline(posts_db_path.string());  // Initialize Timeline directly with file path
+    startup.lap("posts");
 
     // Initialize FriendsManager
     std::unique_ptr<FriendsManager> friendsManager;
     try {
-        friendsManager = std::make_unique<FriendsManager>(auth->getUsers());
-        friendsManager->loadFriends(friends_db_path.string());
-        friendsManager->loadPendingRequests(pending_requests_db_path.string());
-        std::cout << "Friends management system initialized successfully" << std::endl;
+        friendsManager = std::make_unique<FriendsManager>(auth->getUsers(), auth->getUsersMutex());
+        // Snapshots plus the edge log of changes made since
+        friendsManager->open(friends_db_path.string(), pending_requests_db_path.string());
+        startup.lap("friends");
+        // Materialize home timelines and keep them in step with the friend graph
+        timeline.attachFriends(*friendsManager);
+        friendsManager->setFriendshipListener([&timeline](const std::string& userA, const std::string& userB, bool added) {
+            timeline.onFriendshipChanged(userA, userB, added);
+        });
+        startup.lap("home timelines");
+        LOG_INFO("Friends management system initialized successfully");
     } catch (const std::exception& e) {
-        std::cerr << "Failed to initialize friends management system: " << e.what() << std::endl;
+        LOG_ERROR("Failed to initialize friends management system: " << e.what());
         return 1;
     }
 
-    // Initialize User Search BST
-    std::unique_ptr<UserSearchBST> userSearchBST;
+    // Initialize the user search index
+    std::unique_ptr<UserSearchIndex> userSearch;
     try {
-        userSearchBST = std::make_unique<UserSearchBST>();
-        // Populate BST with all users
+        userSearch = std::make_unique<UserSearchIndex>();
+        // Populate the index with all users
         const auto& users = auth->getUsers();
         std::vector<std::string> usernames;
         for (const auto& pair : users) {
             usernames.push_back(pair.first);
         }
-        userSearchBST->rebuildFromUsers(usernames);
-        std::cout << "User search BST initialized with " << usernames.size() << " users" << std::endl;
+        userSearch->rebuildFromUsers(usernames);
+        startup.lap("search");
+        LOG_INFO("User search index initialized with " << userSearch->size() << " users");
     } catch (const std::exception& e) {
-        std::cerr << "Failed to initialize user search BST: " << e.what() << std::endl;
+        LOG_ERROR("Failed to initialize user search index: " << e.what());
         return 1;
     }
+    LOG_INFO("Startup: " << startup.summary());
+
+    if (exportJson) {
+        try {
+            auth->exportUsersJson(users_db_path.string());
+            timeline.exportJson(posts_db_path.string());
+            friendsManager->saveFriends(friends_db_path.string());
+            friendsManager->savePendingRequests(pending_requests_db_path.string());
+            LOG_INFO("Exported JSON snapshots to " << db_path);
+            return 0;
+        } catch (const std::exception& e) {
+            LOG_ERROR("JSON export failed: " << e.what());
+            return 1;
+        }
+    }
 
     // Handle OPTIONS requests for CORS
     CROW_ROUTE(app, "/<path>").methods("OPTIONS"_method)([](const crow::request& req, std::string) {
@@ -175,6 +352,7 @@ int main(int argc, char* argv[]) {
             if (username.empty()) {
                 return makeJsonResponse(req, 401, "Invalid token", true);
             }
+            auth->logout(token);
 
             // Return success response
             crow::json::wvalue result;
@@ -204,9 +382,7 @@ int main(int argc, char* argv[]) {
     });
 
     // --------- SIGNUP ----------
-    CROW_ROUTE(app, "/api/auth/signup").methods("POST"_method)([&auth, &userSearchBST](const crow::request& req) {
-        std::cout << "\n=== Processing Signup Request ===" << std::endl;
-        std::cout << "Request body: " << req.body << std::endl;
+    CROW_ROUTE(app, "/api/auth/signup").methods("POST"_method)([&auth, &userSearch](const crow::request& req) {
 
         try {
             auto data = crow::json::load(req.body);
@@ -223,11 +399,11 @@ int main(int argc, char* argv[]) {
 
             auth->signup(username, password);
             
-            // Add the new user to the search BST
-            userSearchBST->insertUser(username);
+            // Add the new user to the search index
+            userSearch->insertUser(username);
             
-            // Generate token after successful signup
-            std::string token = auth->login(username, password);
+            // The password was just hashed by signup; don't hash it again
+            std::string token = auth->startSession(username);
             
             crow::json::wvalue result;
             result["success"] = true;
@@ -241,16 +417,16 @@ int main(int argc, char* argv[]) {
             res.body = result.dump();
             return res;
 
+        } catch (const HasherBusyError& e) {
+            return makeBusyResponse(req, e.what());
         } catch (const std::exception& e) {
-            std::cerr << "Signup error: " << e.what() << std::endl;
+            LOG_ERROR("Signup error: " << e.what());
             return makeJsonResponse(req, 400, e.what(), true);
         }
     });
 
     // --------- LOGIN ----------
     CROW_ROUTE(app, "/api/auth/login").methods("POST"_method)([&auth](const crow::request& req) {
-        std::cout << "\n=== Processing Login Request ===" << std::endl;
-        std::cout << "Request body: " << req.body << std::endl;
 
         try {
             auto data = crow::json::load(req.body);
@@ -290,8 +466,10 @@ int main(int argc, char* argv[]) {
             res.body = result.dump();
             return res;
 
+        } catch (const HasherBusyError& e) {
+            return makeBusyResponse(req, e.what());
         } catch (const std::exception& e) {
-            std::cerr << "Login error: " << e.what() << std::endl;
+            LOG_ERROR("Login error: " << e.what());
             return makeJsonResponse(req, 400, e.what(), true);
         }
     });
@@ -356,51 +534,21 @@ int main(int argc, char* argv[]) {
                 // If token verification fails, continue without a user
             }
 
-            crow::json::wvalue result = crow::json::wvalue::list();
-            vector<Post>& posts = timeline.getPost();
-            int resultIndex = 0;
-
-            for (const auto& post : posts) {
-                // If filter is "my", only show current user's posts
-                if (filter == "my" && (!currentUser.empty() && post.getPostOwner() != currentUser)) {
-                    continue;
-                }
-
-                crow::json::wvalue post_json;
-                post_json["id"] = post.getPostId();
-                post_json["content"] = post.getPostContent();
-                post_json["owner"] = post.getPostOwner();
-                post_json["timestamp"] = post.getPostTimes();
-
-                // Add reactions
-                crow::json::wvalue reactions_json = crow::json::wvalue::list();
-                const auto& reactions = post.getReactions();
-                int reaction_idx = 0;
-                for (const auto& reaction : reactions) {
-                    reactions_json[reaction_idx++] = reaction;
-                }
-                post_json["reactions"] = std::move(reactions_json);
-
-                // Add comments
-                crow::json::wvalue comments_json = crow::json::wvalue::list();
-                const auto& comments = post.getComments();
-                int comment_idx = 0;
-                for (const auto& comment : comments) {
-                    crow::json::wvalue comment_json;
-                    comment_json["id"] = comment.getCommentId();
-                    comment_json["content"] = comment.getCommentContent();
-                    comment_json["owner"] = comment.getCommentOwner();
-                    comment_json["timestamp"] = comment.getCommentTimes();
-                    comments_json[comment_idx++] = std::move(comment_json);
-                }
-                post_json["comments"] = std::move(comments_json);
-                result[resultIndex++] = std::move(post_json);
+            FeedOptions options;
+            if (!parseFeedOptions(req, options)) {
+                return makeJsonResponse(req, 400, "Invalid limit or cursor", true);
             }
 
+            // If filter is "my", only show current user's posts
+            std::string author = (filter == "my") ? currentUser : "";
+            bool hasMore = false;
+            std::vector<PostPtr> posts = timeline.getPage(options.limit, options.cursor, hasMore, author);
+
             auto res = crow::response(200);
             add_cors_headers(res, req);
             res.set_header("Content-Type", "application/json");
-            res.body = result.dump();
+            setNextCursor(res, posts, hasMore);
+            writeFeed(res.body, timeline, posts, options);
             return res;
         } catch (const std::exception& e) {
             return makeJsonResponse(req, 500, e.what(), true);
@@ -408,7 +556,7 @@ int main(int argc, char* argv[]) {
     });
 
     // Get friends-only posts
-    CROW_ROUTE(app, "/api/posts/friends").methods("GET"_method)([&timeline, &auth, &friendsManager](const crow::request& req) {
+    CROW_ROUTE(app, "/api/posts/friends").methods("GET"_method)([&timeline, &auth](const crow::request& req) {
         try {
             std::string token = getTokenFromRequest(req);
             std::string currentUser = auth->verifyToken(token);
@@ -417,56 +565,25 @@ int main(int argc, char* argv[]) {
                 return makeJsonResponse(req, 401, "Authentication required", true);
             }
 
-            crow::json::wvalue result = crow::json::wvalue::list();
-            vector<Post>& posts = timeline.getPost();
-            int resultIndex = 0;
-
-            // Get user's friends list
-            std::vector<std::string> friends = friendsManager->getFriendList(currentUser);
-            std::unordered_set<std::string> friendSet(friends.begin(), friends.end());
-            friendSet.insert(currentUser); // Include user's own posts
-
-            for (const auto& post : posts) {
-                // Only include posts from friends and the user themselves
-                if (friendSet.find(post.getPostOwner()) == friendSet.end()) {
-                    continue;
-                }
+            FeedOptions options;
+            if (!parseFeedOptions(req, options)) {
+                return makeJsonResponse(req, 400, "Invalid limit or cursor", true);
+            }
 
-                crow::json::wvalue post_json;
-                post_json["id"] = post.getPostId();
-                post_json["content"] = post.getPostContent();
-                post_json["owner"] = post.getPostOwner();
-                post_json["timestamp"] = post.getPostTimes();
-
-                // Add reactions
-                crow::json::wvalue reactions_json = crow::json::wvalue::list();
-                const auto& reactions = post.getReactions();
-                int reaction_idx = 0;
-                for (const auto& reaction : reactions) {
-                    reactions_json[reaction_idx++] = reaction;
-                }
-                post_json["reactions"] = std::move(reactions_json);
-
-                // Add comments
-                crow::json::wvalue comments_json = crow::json::wvalue::list();
-                const auto& comments = post.getComments();
-                int comment_idx = 0;
-                for (const auto& comment : comments) {
-                    crow::json::wvalue comment_json;
-                    comment_json["id"] = comment.getCommentId();
-                    comment_json["content"] = comment.getCommentContent();
-                    comment_json["owner"] = comment.getCommentOwner();
-                    comment_json["timestamp"] = comment.getCommentTimes();
-                    comments_json[comment_idx++] = std::move(comment_json);
-                }
-                post_json["comments"] = std::move(comments_json);
-                result[resultIndex++] = std::move(post_json);
+            // Posts from friends and the user themselves, read from their home timeline.
+            // Post ids grow with time, so the cursor's id is enough to resume.
+            size_t fetch = options.limit == SIZE_MAX ? SIZE_MAX : options.limit + 1;
+            std::vector<PostPtr> posts = timeline.getHomeFeed(currentUser, fetch, options.cursor.position);
+            bool hasMore = posts.size() > options.limit;
+            if (hasMore) {
+                posts.resize(options.limit);
             }
 
             auto res = crow::response(200);
             add_cors_headers(res, req);
             res.set_header("Content-Type", "application/json");
-            res.body = result.dump();
+            setNextCursor(res, posts, hasMore);
+            writeFeed(res.body, timeline, posts, options);
             return res;
         } catch (const std::exception& e) {
             return makeJsonResponse(req, 500, e.what(), true);
@@ -562,7 +679,7 @@ int main(int argc, char* argv[]) {
     });
 
     // Add comment
-    CROW_ROUTE(app, "/api/posts/<string>/comment").methods("POST"_method)([&timeline, &auth](const crow::request& req, std::string postId) {
+    CROW_ROUTE(app, "/api/posts/<string>/comment").methods("POST"_method)([&timeline, &auth, &friendsManager](const crow::request& req, std::string postId) {
         // Verify token
         std::string authHeader = req.get_header_value("Authorization");
         if (authHeader.empty() || authHeader.substr(0, 7) != "Bearer ") {
@@ -576,13 +693,13 @@ int main(int argc, char* argv[]) {
                 return makeJsonResponse(req, 400, "Invalid comment data", true);
             }
 
-            Post* post = timeline.findPost(std::stoi(postId));
+            PostPtr post = timeline.findPost(std::stoi(postId));
             if (!post) {
                 return makeJsonResponse(req, 404, "Post not found", true);
             }
 
-            post->AddComment(data["content"].s(), username);
-            timeline.savePosts();  // Save after adding comment
+            timeline.addComment(std::stoi(postId), data["content"].s(), username);
+            friendsManager->noteInteraction(username, post->getPostOwner());
             
             crow::json::wvalue result;
             result["success"] = true;
@@ -598,8 +715,53 @@ int main(int argc, char* argv[]) {
         }
     });
 
+    // Page through a post's comments, oldest first:
+    //   ?limit=N&cursor=<from X-Next-Cursor>
+    CROW_ROUTE(app, "/api/posts/<string>/comments").methods("GET"_method)([&timeline](const crow::request& req, std::string postId) {
+        try {
+            size_t limit = DEFAULT_COMMENTS_PAGE;
+            int afterId = 0;
+            try {
+                if (const char* value = req.url_params.get("limit")) {
+                    int requested = std::stoi(value);
+                    if (requested <= 0) throw std::invalid_argument("limit");
+                    limit = std::min<size_t>(requested, MAX_COMMENTS_PAGE);
+                }
+                if (const char* cursor = req.url_params.get("cursor")) {
+                    afterId = std::stoi(cursor);
+                }
+            } catch (const std::exception&) {
+                return makeJsonResponse(req, 400, "Invalid limit or cursor", true);
+            }
+
+            bool hasMore = false;
+            std::vector<Comment> page;
+            try {
+                page = timeline.getComments(std::stoi(postId), afterId, limit, hasMore);
+            } catch (const std::runtime_error&) {
+                return makeJsonResponse(req, 404, "Post not found", true);
+            }
+
+            auto res = crow::response(200);
+            add_cors_headers(res, req);
+            res.set_header("Content-Type", "application/json");
+            if (hasMore && !page.empty()) {
+                res.set_header("X-Next-Cursor", std::to_string(page.back().getCommentId()));
+            }
+            JsonWriter json(res.body);
+            json.beginArray();
+            for (const Comment& comment : page) {
+                writeComment(json, comment);
+            }
+            json.endArray();
+            return res;
+        } catch (const std::exception& e) {
+            return makeJsonResponse(req, 500, e.what(), true);
+        }
+    });
+
     // Add reaction
-    CROW_ROUTE(app, "/api/posts/<string>/react").methods("POST"_method)([&timeline, &auth](const crow::request& req, std::string postId) {
+    CROW_ROUTE(app, "/api/posts/<string>/react").methods("POST"_method)([&timeline, &auth, &friendsManager](const crow::request& req, std::string postId) {
         // Verify token
         std::string authHeader = req.get_header_value("Authorization");
         if (authHeader.empty() || authHeader.substr(0, 7) != "Bearer ") {
@@ -608,16 +770,24 @@ int main(int argc, char* argv[]) {
 
         try {
             std::string username = auth->verifyToken(authHeader.substr(7));
-            std::cout << "Reaction request from user: " << username << " for post: " << postId << std::endl;
+            LOG_DEBUG("Reaction request from user: " << username << " for post: " << postId);
             
             auto data = crow::json::load(req.body);
             if (!data || !data.has("type")) {
                 return makeJsonResponse(req, 400, "Invalid reaction data", true);
             }
+            std::string type = data["type"].s();
+            if (!type.empty() && !ReactionSet::isValidType(type)) {
+                return makeJsonResponse(req, 400, "Invalid reaction type", true);
+            }
 
-            std::cout << "Calling timeline.addReaction..." << std::endl;
-            timeline.addReaction(std::stoi(postId), username, data["type"].s());
-            std::cout << "Reaction added successfully" << std::endl;
+            // Only reactions that stay count for suggestions, so repeated
+            // like/unlike can't pump up the interaction signal
+            bool reacted = timeline.addReaction(std::stoi(postId), username, type);
+            PostPtr post = reacted ? timeline.findPost(std::stoi(postId)) : nullptr;
+            if (post) {
+                friendsManager->noteInteraction(username, post->getPostOwner());
+            }
             
             crow::json::wvalue result;
             result["success"] = true;
@@ -629,7 +799,7 @@ int main(int argc, char* argv[]) {
             res.body = result.dump();
             return res;
         } catch (const std::exception& e) {
-            std::cout << "Error in reaction endpoint: " << e.what() << std::endl;
+            LOG_ERROR("Error in reaction endpoint: " << e.what());
             return makeJsonResponse(req, 500, e.what(), true);
         }
     });
@@ -648,13 +818,12 @@ int main(int argc, char* argv[]) {
                 return makeJsonResponse(req, 400, "Invalid comment data", true);
             }
 
-            Post* post = timeline.findPost(std::stoi(postId));
+            PostPtr post = timeline.findPost(std::stoi(postId));
             if (!post) {
                 return makeJsonResponse(req, 404, "Post not found", true);
             }
 
-            post->EditComment(data["content"].s(), username, std::stoi(commentId));
-            timeline.savePosts();
+            timeline.editComment(std::stoi(postId), std::stoi(commentId), username, data["content"].s());
 
             return makeJsonResponse(req, 200, "Comment updated successfully");
         } catch (const std::exception& e) {
@@ -671,13 +840,12 @@ int main(int argc, char* argv[]) {
 
         try {
             std::string username = auth->verifyToken(authHeader.substr(7));
-            Post* post = timeline.findPost(std::stoi(postId));
+            PostPtr post = timeline.findPost(std::stoi(postId));
             if (!post) {
                 return makeJsonResponse(req, 404, "Post not found", true);
             }
 
-            post->deleteComment(username, std::stoi(commentId));
-            timeline.savePosts();
+            timeline.deleteComment(std::stoi(postId), std::stoi(commentId), username);
 
             return makeJsonResponse(req, 200, "Comment deleted successfully");
         } catch (const std::exception& e) {
@@ -688,7 +856,7 @@ int main(int argc, char* argv[]) {
     // --------- FRIENDSHIP MANAGEMENT ENDPOINTS ----------
     
     // Send friend request
-    CROW_ROUTE(app, "/api/friends/request").methods("POST"_method)([&auth, &friendsManager, &pending_requests_db_path](const crow::request& req) {
+    CROW_ROUTE(app, "/api/friends/request").methods("POST"_method)([&auth, &friendsManager](const crow::request& req) {
         try {
             // Verify token and get current user
             std::string token = req.get_header_value("Authorization").substr(7);
@@ -697,12 +865,11 @@ int main(int argc, char* argv[]) {
             // Parse request body
             auto body = crow::json::load(req.body);
             if (!body) {
-                std::cerr << "Invalid request body" << std::endl;
+                LOG_WARN("Invalid request body");
                 return crow::response(400, "Invalid request body");
             }
 
-            std::cout << "Request body: " << req.body << std::endl;
-
+    
             // Check both possible field names
             std::string to;
             if (body.has("username")) {
@@ -710,24 +877,23 @@ int main(int argc, char* argv[]) {
             } else if (body.has("friend_username")) {
                 to = body["friend_username"].s();
             } else {
-                std::cerr << "Missing username field" << std::endl;
+                LOG_WARN("Missing username field");
                 return crow::response(400, "Missing username field");
             }
 
             if (to.empty()) {
-                std::cerr << "Username is empty" << std::endl;
+                LOG_WARN("Username is empty");
                 return crow::response(400, "Username is required");
             }
 
-            std::cout << "Sending friend request from " << from << " to " << to << std::endl;
+            LOG_DEBUG("Sending friend request from " << from << " to " << to);
 
             // Send friend request
             bool success = friendsManager->sendFriendRequest(from, to);
             if (success) {
-                std::cout << "Friend request sent successfully, saving to: " << pending_requests_db_path.string() << std::endl;
-                friendsManager->savePendingRequests(pending_requests_db_path.string());
+                LOG_DEBUG("Friend request sent successfully");
             } else {
-                std::cout << "Failed to send friend request" << std::endl;
+                LOG_DEBUG("Failed to send friend request");
             }
 
             crow::json::wvalue response;
@@ -736,7 +902,7 @@ int main(int argc, char* argv[]) {
             return crow::response(response);
 
         } catch (const std::exception& e) {
-            std::cerr << "Error in friend request: " << e.what() << std::endl;
+            LOG_ERROR("Error in friend request: " << e.what());
             crow::json::wvalue response;
             response["success"] = false;
             response["message"] = std::string("Error: ") + e.what();
@@ -745,7 +911,7 @@ int main(int argc, char* argv[]) {
     });
 
     // Accept friend request
-    CROW_ROUTE(app, "/api/friends/accept").methods("POST"_method)([&auth, &friendsManager, &pending_requests_db_path, &friends_db_path](const crow::request& req) {
+    CROW_ROUTE(app, "/api/friends/accept").methods("POST"_method)([&auth, &friendsManager](const crow::request& req) {
         try {
             // Verify token and get current user
             std::string token = req.get_header_value("Authorization").substr(7);
@@ -754,12 +920,11 @@ int main(int argc, char* argv[]) {
             // Parse request body
             auto body = crow::json::load(req.body);
             if (!body) {
-                std::cerr << "Invalid request body" << std::endl;
+                LOG_WARN("Invalid request body");
                 return crow::response(400, "Invalid request body");
             }
 
-            std::cout << "Request body: " << req.body << std::endl;
-
+    
             // Check both possible field names
             std::string from;
             if (body.has("username")) {
@@ -767,27 +932,23 @@ int main(int argc, char* argv[]) {
             } else if (body.has("friend_username")) {
                 from = body["friend_username"].s();
             } else {
-                std::cerr << "Missing username field" << std::endl;
+                LOG_WARN("Missing username field");
                 return crow::response(400, "Missing username field");
             }
 
             if (from.empty()) {
-                std::cerr << "Username is empty" << std::endl;
+                LOG_WARN("Username is empty");
                 return crow::response(400, "Username is required");
             }
 
-            std::cout << "Accepting friend request from " << from << " to " << to << std::endl;
+            LOG_DEBUG("Accepting friend request from " << from << " to " << to);
 
             // Accept friend request
             bool success = friendsManager->acceptFriendRequest(from, to);
             if (success) {
-                std::cout << "Friend request accepted successfully" << std::endl;
-                std::cout << "Saving pending requests to: " << pending_requests_db_path.string() << std::endl;
-                friendsManager->savePendingRequests(pending_requests_db_path.string());
-                std::cout << "Saving friends to: " << friends_db_path.string() << std::endl;
-                friendsManager->saveFriends(friends_db_path.string());
+                LOG_DEBUG("Friend request accepted successfully");
             } else {
-                std::cout << "Failed to accept friend request" << std::endl;
+                LOG_DEBUG("Failed to accept friend request");
             }
 
             crow::json::wvalue response;
@@ -796,7 +957,7 @@ int main(int argc, char* argv[]) {
             return crow::response(response);
 
         } catch (const std::exception& e) {
-            std::cerr << "Error in accepting friend request: " << e.what() << std::endl;
+            LOG_ERROR("Error in accepting friend request: " << e.what());
             crow::json::wvalue response;
             response["success"] = false;
             response["message"] = std::string("Error: ") + e.what();
@@ -805,7 +966,7 @@ int main(int argc, char* argv[]) {
     });
 
     // Reject friend request
-    CROW_ROUTE(app, "/api/friends/decline").methods("POST"_method)([&auth, &friendsManager, &pending_requests_db_path](const crow::request& req) {
+    CROW_ROUTE(app, "/api/friends/decline").methods("POST"_method)([&auth, &friendsManager](const crow::request& req) {
         try {
             // Verify token and get current user
             std::string token = req.get_header_value("Authorization").substr(7);
@@ -814,12 +975,11 @@ int main(int argc, char* argv[]) {
             // Parse request body
             auto body = crow::json::load(req.body);
             if (!body) {
-                std::cerr << "Invalid request body" << std::endl;
+                LOG_WARN("Invalid request body");
                 return crow::response(400, "Invalid request body");
             }
 
-            std::cout << "Request body: " << req.body << std::endl;
-
+    
             // Check both possible field names
             std::string from;
             if (body.has("username")) {
@@ -827,25 +987,23 @@ int main(int argc, char* argv[]) {
             } else if (body.has("friend_username")) {
                 from = body["friend_username"].s();
             } else {
-                std::cerr << "Missing username field" << std::endl;
+                LOG_WARN("Missing username field");
                 return crow::response(400, "Missing username field");
             }
 
             if (from.empty()) {
-                std::cerr << "Username is empty" << std::endl;
+                LOG_WARN("Username is empty");
                 return crow::response(400, "Username is required");
             }
 
-            std::cout << "Declining friend request from " << from << " to " << to << std::endl;
+            LOG_DEBUG("Declining friend request from " << from << " to " << to);
 
             // Reject friend request
             bool success = friendsManager->rejectFriendRequest(from, to);
             if (success) {
-                std::cout << "Friend request declined successfully" << std::endl;
-                std::cout << "Saving pending requests to: " << pending_requests_db_path.string() << std::endl;
-                friendsManager->savePendingRequests(pending_requests_db_path.string());
+                LOG_DEBUG("Friend request declined successfully");
             } else {
-                std::cout << "Failed to decline friend request" << std::endl;
+                LOG_DEBUG("Failed to decline friend request");
             }
 
             crow::json::wvalue response;
@@ -854,7 +1012,7 @@ int main(int argc, char* argv[]) {
             return crow::response(response);
 
         } catch (const std::exception& e) {
-            std::cerr << "Error in declining friend request: " << e.what() << std::endl;
+            LOG_ERROR("Error in declining friend request: " << e.what());
             crow::json::wvalue response;
             response["success"] = false;
             response["message"] = std::string("Error: ") + e.what();
@@ -863,7 +1021,7 @@ int main(int argc, char* argv[]) {
     });
 
     // Remove friend
-    CROW_ROUTE(app, "/api/friends/remove").methods("DELETE"_method)([&auth, &friendsManager, &friends_db_path](const crow::request& req) {
+    CROW_ROUTE(app, "/api/friends/remove").methods("DELETE"_method)([&auth, &friendsManager](const crow::request& req) {
         try {
             // Verify token and get current user
             std::string token = req.get_header_value("Authorization").substr(7);
@@ -880,16 +1038,14 @@ int main(int argc, char* argv[]) {
                 return crow::response(400, "Friend username is required");
             }
 
-            std::cout << "Removing friend " << friendName << " from " << username << std::endl;
+            LOG_DEBUG("Removing friend " << friendName << " from " << username);
 
             // Remove friend
             bool success = friendsManager->removeFriend(username, friendName);
             if (success) {
-                std::cout << "Friend removed successfully" << std::endl;
-                std::cout << "Saving friends to: " << friends_db_path.string() << std::endl;
-                friendsManager->saveFriends(friends_db_path.string());
+                LOG_DEBUG("Friend removed successfully");
             } else {
-                std::cout << "Failed to remove friend" << std::endl;
+                LOG_DEBUG("Failed to remove friend");
             }
 
             crow::json::wvalue response;
@@ -898,7 +1054,7 @@ int main(int argc, char* argv[]) {
             return crow::response(response);
 
         } catch (const std::exception& e) {
-            std::cerr << "Error in removing friend: " << e.what() << std::endl;
+            LOG_ERROR("Error in removing friend: " << e.what());
             crow::json::wvalue response;
             response["success"] = false;
             response["message"] = std::string("Error: ") + e.what();
@@ -906,18 +1062,44 @@ int main(int argc, char* argv[]) {
         }
     });
 
-    // Get friend list
+    // Get friend list, sorted by name. Paged with ?limit=N&after=<name>: pass
+    // the "next" of one page as 'after' to get the following one.
     CROW_ROUTE(app, "/api/friends").methods("GET"_method)([&auth, &friendsManager](const crow::request& req) {
         try {
             // Verify token and get current user
             std::string token = req.get_header_value("Authorization").substr(7);
             std::string username = auth->verifyToken(token);
 
-            // Get friend list
-            std::vector<std::string> friends = friendsManager->getFriendList(username);
+            const char* afterParam = req.url_params.get("after");
+            const char* limitParam = req.url_params.get("limit");
+            if (!afterParam && !limitParam) {
+                crow::json::wvalue response;
+                response["success"] = true;
+                response["friends"] = friendsManager->getFriendList(username);
+                return crow::response(response);
+            }
+
+            size_t limit = MAX_FRIENDS_PAGE;
+            if (limitParam) {
+                try {
+                    int value = std::stoi(limitParam);
+                    if (value <= 0) throw std::invalid_argument("limit");
+                    limit = std::min<size_t>(value, MAX_FRIENDS_PAGE);
+                } catch (const std::exception&) {
+                    return makeJsonResponse(req, 400, "Invalid limit", true);
+                }
+            }
+
+            bool hasMore = false;
+            std::vector<std::string> friends =
+                friendsManager->getFriendPage(username, afterParam ? afterParam : "", limit, hasMore);
 
             crow::json::wvalue response;
             response["success"] = true;
+            response["hasMore"] = hasMore;
+            if (hasMore) {
+                response["next"] = friends.back();
+            }
             response["friends"] = friends;
             return crow::response(response);
 
@@ -954,19 +1136,72 @@ int main(int argc, char* argv[]) {
         }
     });
     
-    // Get friend suggestions
+    // Mutual friends with several users at once:
+    //   ?users=a,b,c (at most 200) &names=true to list them, not just count
+    CROW_ROUTE(app, "/api/friends/mutual").methods("GET"_method)([&](const crow::request& req) {
+        try {
+            std::string username = auth->verifyToken(getTokenFromRequest(req));
+
+            std::vector<std::string> others;
+            if (const char* usersParam = req.url_params.get("users")) {
+                std::stringstream list(usersParam);
+                std::string name;
+                while (std::getline(list, name, ',')) {
+                    if (!name.empty()) others.push_back(name);
+                }
+            }
+            if (others.empty() || others.size() > MAX_MUTUAL_BATCH) {
+                return makeJsonResponse(req, 400, "Expected 1 to 200 comma-separated users", true);
+            }
+            const char* namesParam = req.url_params.get("names");
+            bool withNames = namesParam && std::string(namesParam) == "true";
+
+            crow::json::wvalue result;
+            result["success"] = true;
+            for (const MutualFriends& entry : friendsManager->getMutualFriendsBatch(username, others, withNames)) {
+                result["mutual"][entry.user]["count"] = entry.count;
+                if (withNames) {
+                    result["mutual"][entry.user]["names"] = entry.names;
+                }
+            }
+
+            auto res = crow::response(200);
+            add_cors_headers(res, req);
+            res.set_header("Content-Type", "application/json");
+            res.body = result.dump();
+            return res;
+
+        } catch (const std::exception& e) {
+            return makeJsonResponse(req, 500, e.what(), true);
+        }
+    });
+
+    // Get friend suggestions, best first (?limit=N, at most 50)
     CROW_ROUTE(app, "/api/friends/suggestions").methods("GET"_method)([&](const crow::request& req) {
         try {
             std::string username = auth->verifyToken(getTokenFromRequest(req));
-            
-            std::vector<std::string> suggestions = friendsManager->suggestFriends(username);
+
+            size_t limit = DEFAULT_SUGGESTIONS;
+            if (const char* limitParam = req.url_params.get("limit")) {
+                try {
+                    int value = std::stoi(limitParam);
+                    if (value <= 0) throw std::invalid_argument("limit");
+                    limit = std::min<size_t>(value, FriendSuggestions::TOP_K);
+                } catch (const std::exception&) {
+                    return makeJsonResponse(req, 400, "Invalid limit", true);
+                }
+            }
+
+            auto suggestions = friendsManager->suggestFriends(username, limit);
             
             crow::json::wvalue result;
             result["success"] = true;
             result["suggestions"] = crow::json::wvalue::list();
+            result["mutualCounts"] = crow::json::wvalue::object();
             
             for (size_t i = 0; i < suggestions.size(); i++) {
-                result["suggestions"][i] = suggestions[i];
+                result["suggestions"][i] = suggestions[i].first;
+                result["mutualCounts"][suggestions[i].first] = suggestions[i].second;
             }
             
             auto res = crow::response(200);
@@ -980,10 +1215,9 @@ int main(int argc, char* argv[]) {
         }
     });
 
-    // User search endpoint using BST
-    CROW_ROUTE(app, "/api/users/search").methods("GET"_method)([&auth, &userSearchBST](const crow::request& req) {
+    // User search endpoint (?q=&type=prefix|substring&limit=N)
+    CROW_ROUTE(app, "/api/users/search").methods("GET"_method)([&auth, &userSearch](const crow::request& req) {
         try {
-            std::cout << "\n=== SEARCH REQUEST RECEIVED ===" << std::endl;
             
             // Get search query and type from URL parameters
             std::string query = req.url_params.get("q") ? req.url_params.get("q") : "";
@@ -997,7 +1231,18 @@ int main(int argc, char* argv[]) {
                 return crow::response(response);
             }
 
-            std::cout << "Search query: '" << query << "', type: " << searchType << std::endl;
+            LOG_DEBUG("Search query: '" << query << "', type: " << searchType);
+
+            size_t limit = SIZE_MAX;
+            if (const char* limitParam = req.url_params.get("limit")) {
+                try {
+                    int value = std::stoi(limitParam);
+                    if (value <= 0) throw std::invalid_argument("limit");
+                    limit = static_cast<size_t>(value);
+                } catch (const std::exception&) {
+                    return makeJsonResponse(req, 400, "Invalid limit", true);
+                }
+            }
 
             // Get current user if authenticated
             std::string currentUser;
@@ -1010,29 +1255,24 @@ int main(int argc, char* argv[]) {
                 // If token verification fails, continue without a user
             }
 
-            // Perform search
+            // Perform search; one extra result in case the current user is among them
+            size_t fetch = limit == SIZE_MAX ? SIZE_MAX : limit + 1;
             std::vector<std::string> results;
             if (searchType == "prefix") {
-                std::cout << "Performing prefix search..." << std::endl;
-                results = userSearchBST->searchByPrefix(query);
+                results = userSearch->searchByPrefix(query, fetch);
             } else {
-                std::cout << "Performing substring search..." << std::endl;
-                results = userSearchBST->searchBySubstring(query);
+                results = userSearch->searchBySubstring(query, fetch);
             }
 
             // Filter out current user from results
             std::vector<std::string> filtered_results;
             for (const auto& username : results) {
-                if (username != currentUser) {
+                if (username != currentUser && filtered_results.size() < limit) {
                     filtered_results.push_back(username);
                 }
             }
 
-            // Print response for debugging
-            std::cout << "Sending response with " << filtered_results.size() << " results" << std::endl;
-            for (const auto& username : filtered_results) {
-                std::cout << "Result: " << username << std::endl;
-            }
+            LOG_DEBUG("Search '" << query << "' returned " << filtered_results.size() << " results");
 
             // Create response in the format expected by the frontend
             crow::json::wvalue response;
@@ -1045,7 +1285,7 @@ int main(int argc, char* argv[]) {
             return res;
 
         } catch (const std::exception& e) {
-            std::cerr << "Error in search: " << e.what() << std::endl;
+            LOG_ERROR("Error in search: " << e.what());
             crow::json::wvalue error_response;
             error_response["success"] = false;
             error_response["message"] = std::string("Search error: ") + e.what();
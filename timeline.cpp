@@ -5,309 +5,738 @@
 #include <ctime>
 #include <filesystem>
 #include "include/timeline.h"
+#include "include/Logger.h"
 
 using namespace std;
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
-//---------------------------------------------------
-//Definition of comment class methods
-//---------------------------------------------------
-Comment::Comment(int id, int pId, const string& o, const string& c) 
-    : commentId(id), postId(pId), owner(o), content(c), timestamp(time(nullptr)) {}
-
-json Comment::CommentToJson() const {
-    return {
-        {"id", commentId},
-        {"postId", postId},
-        {"owner", owner},
-        {"content", content},
-        {"timestamp", timestamp}
-    };
-}
-
-Comment Comment::CommentFromJson(const json& j) {
-    Comment c(
-        j["id"],
-        j["postId"],
-        j["owner"],
-        j["content"]
-    );
-    c.timestamp = j["timestamp"];
-    return c;
-}
-
-int Comment::getCommentId() const { return commentId; }
-string Comment::getCommentContent() const { return content; }
-string Comment::getCommentOwner() const { return owner; }
-time_t Comment::getCommentTimes() const { return timestamp; }
-
-void Comment::setContent(const string& c) {
-    content = c;
-}
-
-void Comment::setTimestamp(time_t newTime) {
-    timestamp = newTime;
-}
-
 //------------------------------------------------------------
 //Definition of Post class methods
 //------------------------------------------------------------
 
 int Post::getPostId() const { return id; }
-string Post::getPostContent() const { return content; }
-string Post::getPostOwner() const { return owner; }
+string_view Post::getPostContent() const { return ContentHeap::global().view(content); }
+const string& Post::getPostOwner() const { return owner.str(); }
 time_t Post::getPostTimes() const { return timestamp; }
 
 Post::Post(int i, const string& c, const string& o)
-    : id(i), content(c), owner(o), timestamp(time(nullptr)) {}
+    : id(i), content(ContentHeap::global().append(c)), owner(o), timestamp(time(nullptr)) {}
 
-void Post::AddComment(const string& comment, const string& username) {
-    Comment newComment(nextCommentId++, id, username, comment);
-    commentVec.push_back(newComment);
-}
+Post::Post(int i, string_view c, Symbol o, time_t t)
+    : id(i), content(ContentHeap::global().append(c)), owner(o), timestamp(t) {}
 
-void Post::EditComment(const string& newComment, const string& username, int commentId) {
-    for (auto& target : commentVec) {
-        if (target.getCommentId() == commentId) {
-            if (target.getCommentOwner() != username) {
-                throw runtime_error("Unauthorized: Cannot edit others' comments");
-            }
-            target.setContent(newComment);
-            target.setTimestamp(time(nullptr));
-            return;
-        }
-    }
-    throw runtime_error("Comment not found");
+void Post::setCommentSummary(size_t count, vector<Comment> preview) {
+    commentCount = count;
+    commentPreview = move(preview);
 }
 
-void Post::deleteComment(const string& username, int commentId) {
-    for (auto it = commentVec.begin(); it != commentVec.end(); ++it) {
-        if (it->getCommentId() == commentId) {
-            if (it->getCommentOwner() != username) {
-                throw runtime_error("Unauthorized: Cannot delete others' comments");
-            }
-            commentVec.erase(it);
-            return;
-        }
-    }
-    throw runtime_error("Comment not found");
-}
+// Reaction methods
 
-const vector<Comment>& Post::getComments() const {
-    return commentVec;
+// Empty means a like. Unknown types can only come from data written before
+// types were checked, and are loaded as likes.
+static Symbol reactionType(const string& type) {
+    return Symbol(ReactionSet::isValidType(type) ? type : "like");
 }
 
-// Reaction methods
-void Post::addReaction(const string& username) {
-    // Check if user already reacted
-    auto it = find(reactions.begin(), reactions.end(), username);
-    if (it == reactions.end()) {
-        reactions.push_back(username);
-    }
+void Post::addReaction(const string& username, const string& type) {
+    reactions.set(Symbol(username), reactionType(type));
 }
 
 void Post::removeReaction(const string& username) {
-    auto it = find(reactions.begin(), reactions.end(), username);
-    if (it != reactions.end()) {
-        reactions.erase(it);
-    }
+    reactions.erase(Symbol(username));
+}
+
+bool Post::toggleReaction(const string& username, const string& type) {
+    return reactions.toggle(Symbol(username), reactionType(type));
 }
 
 bool Post::hasReaction(const string& username) const {
-    return find(reactions.begin(), reactions.end(), username) != reactions.end();
+    return reactions.contains(Symbol(username));
 }
 
 int Post::getReactionCount() const {
     return reactions.size();
 }
 
-const vector<string>& Post::getReactions() const {
+const ReactionSet& Post::getReactions() const {
     return reactions;
 }
 
 Post Post::fromJson(const json& j) {
     Post p(j.at("id").get<int>(), j.at("content").get<string>(), j.at("owner").get<string>());
     p.timestamp = j.at("timestamp").get<time_t>();
-    if (j.contains("comments")) {
-        for (const auto& cj : j.at("comments")) {
-            p.commentVec.push_back(Comment::CommentFromJson(cj));
-        }
-    }
     if (j.contains("reactions")) {
-        for (const auto& reaction : j.at("reactions")) {
-            p.reactions.push_back(reaction.get<string>());
+        const json& reactions = j.at("reactions");
+        if (reactions.is_object()) {
+            // type -> users who reacted with it
+            for (auto it = reactions.begin(); it != reactions.end(); ++it) {
+                for (const auto& user : it.value()) {
+                    p.addReaction(user.get<string>(), it.key());
+                }
+            }
+        } else {
+            // Older snapshots: a flat list of users who liked the post
+            for (const auto& user : reactions) {
+                p.addReaction(user.get<string>());
+            }
         }
     }
-    // You might want to set the nextCommentId here as well
+    // The comments themselves go to the CommentStore (PostsManager::loadComments)
     int maxCommentId = 0;
-    for(const auto& comment : p.commentVec) {
-        if (comment.getCommentId() > maxCommentId) {
-            maxCommentId = comment.getCommentId();
+    if (j.contains("comments")) {
+        for (const auto& cj : j.at("comments")) {
+            maxCommentId = max(maxCommentId, cj.at("id").get<int>());
         }
     }
-    p.setNextCommentId(maxCommentId + 1);
+    p.setNextCommentId(max(maxCommentId + 1, j.value("nextCommentId", 1)));
 
     return p;
 }
 
-void Post::Edit(const string& newContent) {
-    content = newContent;
+void Post::writeBinary(SnapshotWriter& out) const {
+    out.i32(id);
+    out.i64(timestamp);
+    out.symbol(owner);
+    out.str(getPostContent());
+    out.i32(nextCommentId);
+    out.u32(static_cast<uint32_t>(reactions.size()));
+    reactions.forEach([&out](Symbol user, Symbol type) {
+        out.symbol(user);
+        out.symbol(type);
+    });
+}
+
+Post Post::readBinary(SnapshotReader& in) {
+    int postId = in.i32();
+    time_t time = static_cast<time_t>(in.i64());
+    Symbol author = in.symbol();
+    Post p(postId, in.str(), author, time);
+    p.nextCommentId = in.i32();
+    uint32_t reactionCount = in.u32();
+    for (uint32_t i = 0; i < reactionCount; i++) {
+        Symbol user = in.symbol();
+        Symbol type = in.symbol();
+        p.reactions.set(user, ReactionSet::isValidType(type.str()) ? type : Symbol("like"));
+    }
+    return p;
+}
+
+void Post::Edit(string_view newContent) {
+    ContentHeap::global().release(content);
+    content = ContentHeap::global().append(newContent);
 }
 
 json Post::PostToJson() const {
     json j;
     j["id"] = id;
-    j["content"] = content;
-    j["owner"] = owner;
+    j["content"] = string(getPostContent());
+    j["owner"] = owner.str();
     j["timestamp"] = timestamp;
+    j["nextCommentId"] = nextCommentId;
 
-    json comments_json = json::array();
-    for (const auto& comment : commentVec) {
-        comments_json.push_back(comment.CommentToJson());
-    }
-    j["comments"] = comments_json;
-    
-    json reactions_json = json::array();
-    for (const auto& reaction : reactions) {
-        reactions_json.push_back(reaction);
-    }
+    // Grouped by type so each entry is just the username
+    json reactions_json = json::object();
+    reactions.forEach([&reactions_json](Symbol user, Symbol type) {
+        reactions_json[type.str()].push_back(user.str());
+    });
     j["reactions"] = reactions_json;
 
     return j;
 }
 
+//--------------------------------------------------------------------------
+//Feed cursors
+//--------------------------------------------------------------------------
+string FeedCursor::encode() const {
+    stringstream ss;
+    ss << std::hex << (long long)position.timestamp << '.' << position.id;
+    return ss.str();
+}
+
+bool FeedCursor::decode(const string& text, FeedCursor& cursor) {
+    size_t dot = text.find('.');
+    if (dot == string::npos || dot == 0 || dot + 1 == text.size()) return false;
+    try {
+        size_t used = 0;
+        long long ts = stoll(text.substr(0, dot), &used, 16);
+        if (used != dot) return false;
+        int id = stoi(text.substr(dot + 1), &used, 16);
+        if (used != text.size() - dot - 1) return false;
+        cursor.position = PostKey{(time_t)ts, id};
+        return true;
+    } catch (const exception&) {
+        return false;
+    }
+}
+
 //--------------------------------------------------------------------------
 //Definition of posts manager class
 //--------------------------------------------------------------------------
-PostsManager::PostsManager(const string& file) : filePath(file), nextPostId(1) {
+PostsManager::PostsManager(const string& file)
+    : filePath(file), snapshotPath(snapshot::binaryPath(file)), nextPostId(1), journal(file + ".wal") {
     loadPosts();
+    compactor = thread(&PostsManager::compactorLoop, this);
+}
+
+PostsManager::~PostsManager() {
+    {
+        lock_guard<mutex> lock(postsMutex);
+        stopCompactor = true;
+    }
+    compactorCv.notify_all();
+    if (compactor.joinable()) {
+        compactor.join();
+    }
+    try {
+        if (journal.size() > 0) {
+            savePosts();
+        }
+    } catch (const exception& e) {
+        LOG_ERROR("Error compacting posts journal on shutdown: " << e.what());
+    }
+}
+
+void PostsManager::compactorLoop() {
+    unique_lock<mutex> lock(postsMutex);
+    while (!stopCompactor) {
+        compactorCv.wait_for(lock, compactInterval, [this] { return stopCompactor; });
+        if (stopCompactor) break;
+        if (journal.size() < compactThreshold) continue;
+
+        lock.unlock();
+        try {
+            savePosts();
+        } catch (const exception& e) {
+            LOG_ERROR("Error compacting posts journal: " << e.what());
+        }
+        lock.lock();
+    }
 }
 
 void PostsManager::Add_post(const string& post, const string& name) {
-    Post newPost(nextPostId++, post, name);
-    PostsVec.push_back(newPost);
-    savePosts();
+    PostPtr newPost;
+    {
+        lock_guard<mutex> lock(postsMutex);
+        newPost = make_shared<Post>(nextPostId++, post, name);
+        posts.insert(newPost->getPostId(), newPost);
+        indexPost(*newPost);
+        journal.append({{"op", "post_add"}, {"post", newPost->PostToJson()}});
+        posts.publish();
+    }
+    onPostAdded(*newPost);
 }
 
 void PostsManager::loadPosts() {
-    ifstream file(filePath);
-    if (!file.is_open()) {
-        return; // File might not exist on first run
-    }
-    json data;
-    // Check if the file is empty before parsing
-    file.seekg(0, ios::end);
-    if (file.tellg() == 0) {
-        // File is empty, skip parsing
-        return;
+    auto started = chrono::steady_clock::now();
+    posts.clear();
+    comments.clear();
+    nextPostId = 1;
+    string source;
+    vector<PostPtr> loaded;
+    if (fs::exists(snapshotPath)) {
+        loadBinary(loaded);
+        source = snapshotPath;
+    } else {
+        // No binary snapshot yet: import the JSON one (if any)
+        ifstream file(filePath);
+        json data;
+        // Skip parsing if the snapshot doesn't exist yet (first run) or is empty
+        if (file.is_open()) {
+            file.seekg(0, ios::end);
+            if (file.tellg() > 0) {
+                file.seekg(0, ios::beg);
+                file >> data;
+            }
+        }
+        loadJson(data, loaded);
+        source = filePath;
     }
-    file.seekg(0, ios::beg);
-    file >> data;
+    buildIndexes(loaded);
+
+    // Bring the snapshot up to date with everything logged since it was written
+    size_t replayed = journal.replay([this](const json& record) { applyRecord(record); });
+    if (replayed > 0) {
+        LOG_INFO("Replayed " << replayed << " journal records from " << journal.getPath());
+    }
+    posts.publish();
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started);
+    LOG_INFO("Loaded " << posts.size() << " posts from " << source << " in " << elapsed.count() << " ms");
+}
+
+void PostsManager::loadJson(const json& data, vector<PostPtr>& loaded) {
+    int maxId = 0;
     if (data.contains("posts")) {
-        PostsVec.clear();
         for (const auto& post_json : data["posts"]) {
-            PostsVec.push_back(Post::fromJson(post_json));
+            auto post = make_shared<Post>(Post::fromJson(post_json));
+            maxId = std::max(maxId, post->getPostId());
+            if (posts.insert(post->getPostId(), post)) {
+                loadComments(*post, post_json);
+                loaded.push_back(move(post));
+            } else {
+                ContentHeap::global().release(post->getContentRef()); // duplicate id
+            }
         }
     }
+    nextPostId = maxId + 1;
+    if (data.contains("nextPostId")) {
+        nextPostId = std::max(nextPostId, data["nextPostId"].get<int>());
+    }
+}
 
-    int maxId = 0;
-    if (!PostsVec.empty()) {
-        maxId = std::max_element(PostsVec.begin(), PostsVec.end(), 
-            [](const Post& a, const Post& b) {
-                return a.getPostId() < b.getPostId();
-            })->getPostId();
+// Binary layout: nextPostId, post count, then per post its record followed
+// by its comment thread
+void PostsManager::loadBinary(vector<PostPtr>& loaded) {
+    SnapshotReader in(snapshotPath, snapshot::POSTS);
+    nextPostId = in.i32();
+    uint32_t count = in.u32();
+    for (uint32_t i = 0; i < count; i++) {
+        auto post = make_shared<Post>(Post::readBinary(in));
+        int postId = post->getPostId();
+        uint32_t commentCount = in.u32();
+        for (uint32_t c = 0; c < commentCount; c++) {
+            int commentId = in.i32();
+            time_t timestamp = static_cast<time_t>(in.i64());
+            Symbol owner = in.symbol();
+            comments.put(Comment(commentId, postId, owner, in.str(), timestamp));
+        }
+        if (posts.insert(postId, post)) {
+            refreshCommentSummary(*post);
+            loaded.push_back(move(post));
+        } else {
+            ContentHeap::global().release(post->getContentRef()); // duplicate id
+        }
     }
-    nextPostId = maxId + 1;
+    if (!in.done()) {
+        throw runtime_error("Trailing data in posts snapshot: " + snapshotPath);
+    }
+}
 
+// Replay must be idempotent: after a crash mid-compaction the rotated log is
+// replayed on top of a snapshot that already contains its effects.
+void PostsManager::applyRecord(const json& record) {
+    const string op = record.value("op", "");
+    if (op == "post_add") {
+        // Already present: skip it before its text is copied into the heap
+        int id = record.at("post").at("id").get<int>();
+        nextPostId = std::max(nextPostId, id + 1);
+        if (posts.find(id)) return;
+        auto post = make_shared<Post>(Post::fromJson(record.at("post")));
+        posts.insert(id, post);
+        indexPost(*post);
+        loadComments(*post, record.at("post"));
+        return;
+    }
+
+    PostPtr post = posts.find(record.value("postId", record.value("id", 0)));
+    if (op == "post_delete") {
+        if (PostPtr removed = posts.erase(record.at("id").get<int>())) {
+            unindexPost(*removed);
+            comments.dropPost(removed->getPostId());
+            ContentHeap::global().release(removed->getContentRef());
+        }
+    } else if (!post) {
+        return; // post was deleted later on
+    } else if (op == "post_edit") {
+        post->Edit(record.at("content").get<string>());
+    } else if (op == "comment_add" || op == "comment_edit") {
+        Comment comment = Comment::CommentFromJson(record.at("comment"));
+        post->noteCommentId(comment.getCommentId());
+        comments.put(comment);
+        refreshCommentSummary(*post);
+    } else if (op == "comment_delete") {
+        comments.erase(post->getPostId(), record.at("commentId").get<int>());
+        refreshCommentSummary(*post);
+    } else if (op == "reaction") {
+        const string user = record.at("user").get<string>();
+        if (record.at("on").get<bool>()) {
+            post->addReaction(user, record.value("type", "like"));
+        } else {
+            post->removeReaction(user);
+        }
+    } else {
+        LOG_WARN("Unknown journal record: " << op);
+    }
 }
 
 void PostsManager::savePosts() {
-    json posts_json_array = json::array();
-    for (const auto& post : PostsVec) {
-        posts_json_array.push_back(post.PostToJson());
+    lock_guard<mutex> compactLock(compactMutex);
+
+    // Rotate first: anything applied before the rotation is picked up below,
+    // anything logged after it lands in the new log and replays idempotently.
+    SnapshotWriter out;
+    {
+        lock_guard<mutex> lock(postsMutex);
+        journal.rotate();
+        out.i32(nextPostId);
+    }
+    PostsSnapshot current = getSnapshot();
+    out.u32(static_cast<uint32_t>(current->size()));
+    for (const auto& post : *current) {
+        shared_lock<shared_mutex> lock(postLock(post->getPostId()));
+        post->writeBinary(out);
+        out.u32(static_cast<uint32_t>(comments.count(post->getPostId())));
+        comments.forEach(post->getPostId(), [&out](const Comment& comment) {
+            out.i32(comment.getCommentId());
+            out.i64(comment.getCommentTimes());
+            out.symbol(Symbol(comment.getCommentOwner()));
+            out.str(comment.getCommentContent());
+        });
     }
 
+    // Written next to the old snapshot and swapped in, so a crash never leaves a half-written one
+    out.save(snapshotPath, snapshot::POSTS);
+    journal.dropRotated();
+}
+
+void PostsManager::exportJson(const string& path) const {
     json final_json;
+    {
+        lock_guard<mutex> lock(postsMutex);
+        final_json["nextPostId"] = nextPostId;
+    }
+    json posts_json_array = json::array();
+    PostsSnapshot current = getSnapshot();
+    for (const auto& post : *current) {
+        shared_lock<shared_mutex> lock(postLock(post->getPostId()));
+        json post_json = post->PostToJson();
+        json comments_json = json::array();
+        comments.forEach(post->getPostId(), [&comments_json](const Comment& comment) {
+            comments_json.push_back(comment.CommentToJson());
+        });
+        post_json["comments"] = comments_json;
+        posts_json_array.push_back(post_json);
+    }
     final_json["posts"] = posts_json_array;
 
-    ofstream file(filePath);
-    if (file.is_open()) {
-        file << final_json.dump(4);
-    } else {
-        throw runtime_error("Error opening posts file for writing.");
-    }
+    snapshot::replaceFile(path, {final_json.dump(4)});
 }
 
 void PostsManager::EditPost(int id, string& username, const string& newContent) {
-    for (auto& post : PostsVec) {
-        if (post.getPostId() == id) {
-            if (post.getPostOwner() != username) {
-                throw runtime_error("Unauthorized: Cannot edit others' posts");
-            }
-            post.Edit(newContent);
-            savePosts();
-            return;
-        }
+    PostPtr post = findPost(id);
+    if (!post) {
+        throw runtime_error("Post not found");
+    }
+    unique_lock<shared_mutex> lock(postLock(id));
+    if (post->getPostOwner() != username) {
+        throw runtime_error("Unauthorized: Cannot edit others' posts");
     }
-    throw runtime_error("Post not found");
+    post->Edit(newContent);
+    journal.append({{"op", "post_edit"}, {"id", id}, {"content", newContent}});
 }
 
 void PostsManager::deletePost(int id) {
-    auto it = find_if(PostsVec.begin(), PostsVec.end(),
-        [id](const Post& p) { return p.getPostId() == id; });
-    if (it != PostsVec.end()) {
-        PostsVec.erase(it);
-        savePosts();
-    } else {
+    PostPtr removed;
+    {
+        lock_guard<mutex> lock(postsMutex);
+        removed = posts.erase(id);
+        if (!removed) {
+            throw runtime_error("Post not found");
+        }
+        unindexPost(*removed);
+        journal.append({{"op", "post_delete"}, {"id", id}});
+        posts.publish();
+    }
+    {
+        unique_lock<shared_mutex> lock(postLock(id));
+        comments.dropPost(id);
+    }
+    // Readers still holding the post can read the text: the heap only
+    // counts it as dead
+    ContentHeap::global().release(removed->getContentRef());
+    onPostRemoved(*removed);
+}
+
+void PostsManager::addComment(int postId, const string& comment, const string& username) {
+    PostPtr post = findPost(postId);
+    if (!post) {
+        throw runtime_error("Post not found");
+    }
+    unique_lock<shared_mutex> lock(postLock(postId));
+    // deletePost drops the comments under this lock after unpublishing the
+    // post, so check it is still there or the comment would be orphaned
+    if (findPost(postId) != post) {
+        throw runtime_error("Post not found");
+    }
+    Comment newComment(post->takeCommentId(), postId, username, comment);
+    comments.put(newComment);
+    refreshCommentSummary(*post);
+    journal.append({{"op", "comment_add"}, {"postId", postId}, {"comment", newComment.CommentToJson()}});
+}
+
+void PostsManager::editComment(int postId, int commentId, const string& username, const string& newComment) {
+    PostPtr post = findPost(postId);
+    if (!post) {
+        throw runtime_error("Post not found");
+    }
+    unique_lock<shared_mutex> lock(postLock(postId));
+    Comment* target = comments.find(postId, commentId);
+    if (!target) {
+        throw runtime_error("Comment not found");
+    }
+    if (target->getCommentOwner() != username) {
+        throw runtime_error("Unauthorized: Cannot edit others' comments");
+    }
+    target->setContent(newComment);
+    target->setTimestamp(time(nullptr));
+    refreshCommentSummary(*post);
+    journal.append({{"op", "comment_edit"}, {"postId", postId}, {"comment", target->CommentToJson()}});
+}
+
+void PostsManager::deleteComment(int postId, int commentId, const string& username) {
+    PostPtr post = findPost(postId);
+    if (!post) {
         throw runtime_error("Post not found");
     }
+    unique_lock<shared_mutex> lock(postLock(postId));
+    Comment* target = comments.find(postId, commentId);
+    if (!target) {
+        throw runtime_error("Comment not found");
+    }
+    if (target->getCommentOwner() != username) {
+        throw runtime_error("Unauthorized: Cannot delete others' comments");
+    }
+    comments.erase(postId, commentId);
+    refreshCommentSummary(*post);
+    journal.append({{"op", "comment_delete"}, {"postId", postId}, {"commentId", commentId}});
+}
+
+vector<Comment> PostsManager::getComments(int postId, int afterId, size_t limit, bool& hasMore) const {
+    PostPtr post = findPost(postId);
+    if (!post) {
+        throw runtime_error("Post not found");
+    }
+    shared_lock<shared_mutex> lock(postLock(postId));
+    return comments.page(postId, afterId, limit, hasMore);
+}
+
+void PostsManager::refreshCommentSummary(Post& post) {
+    int postId = post.getPostId();
+    post.setCommentSummary(comments.count(postId), comments.latest(postId, Post::COMMENT_PREVIEW));
+}
+
+void PostsManager::loadComments(Post& post, const json& post_json) {
+    if (!post_json.contains("comments")) return;
+    for (const auto& cj : post_json.at("comments")) {
+        comments.put(Comment::CommentFromJson(cj));
+    }
+    refreshCommentSummary(post);
+}
+
+PostPtr PostsManager::findPost(int postId) const {
+    return posts.find(postId);
+}
+
+// Snapshots list posts by id, which is also time order unless clocks moved
+// back, so the sort is usually skipped; each index is then built bottom-up
+// in O(n) rather than with one insert (and its rotations) per post.
+void PostsManager::buildIndexes(vector<PostPtr>& loaded) {
+    auto keyOf = [](const PostPtr& post) { return PostKey{post->getPostTimes(), post->getPostId()}; };
+    auto byKey = [&keyOf](const PostPtr& a, const PostPtr& b) { return keyOf(a) < keyOf(b); };
+    if (!is_sorted(loaded.begin(), loaded.end(), byKey)) {
+        sort(loaded.begin(), loaded.end(), byKey);
+    }
+
+    vector<PostKey> keys;
+    keys.reserve(loaded.size());
+    unordered_map<string, vector<PostKey>> byAuthor;
+    for (const PostPtr& post : loaded) {
+        keys.push_back(keyOf(post));
+        byAuthor[post->getPostOwner()].push_back(keys.back());
+    }
+
+    unique_lock<shared_mutex> lock(indexMutex);
+    timeIndex = PostIndex(keys.begin(), keys.end(), indexPool);
+    authorIndex.clear();
+    authorIndex.reserve(byAuthor.size());
+    for (auto& [owner, ownerKeys] : byAuthor) {
+        authorIndex.emplace(owner, PostIndex(ownerKeys.begin(), ownerKeys.end(), indexPool));
+    }
+}
+
+void PostsManager::indexPost(const Post& post) {
+    PostKey key{post.getPostTimes(), post.getPostId()};
+    unique_lock<shared_mutex> lock(indexMutex);
+    timeIndex.insert(key);
+    authorIndex.try_emplace(post.getPostOwner(), indexPool).first->second.insert(key);
 }
 
-vector<Post>& PostsManager::getPost() {
-    return PostsVec;
+void PostsManager::unindexPost(const Post& post) {
+    PostKey key{post.getPostTimes(), post.getPostId()};
+    unique_lock<shared_mutex> lock(indexMutex);
+    timeIndex.remove(key);
+    auto it = authorIndex.find(post.getPostOwner());
+    if (it != authorIndex.end()) {
+        it->second.remove(key);
+    }
 }
 
-Post* PostsManager::findPost(int postId) {
-    for (auto& post : PostsVec) {
-        if (post.getPostId() == postId) {
-            return &post;
+vector<PostPtr> PostsManager::getPage(size_t limit, const FeedCursor& cursor, bool& hasMore, const string& author) const {
+    vector<PostPtr> page;
+    hasMore = false;
+    shared_lock<shared_mutex> lock(indexMutex);
+    const PostIndex* index = &timeIndex;
+    if (!author.empty()) {
+        auto it = authorIndex.find(author);
+        if (it == authorIndex.end()) return page;
+        index = &it->second;
+    }
+    index->visitDescendingBelow(cursor.position, [&](const PostKey& key) {
+        if (page.size() == limit) {
+            hasMore = true;
+            return false;
+        }
+        if (PostPtr post = posts.find(key.id)) {
+            page.push_back(post);
+        }
+        return true;
+    });
+    return page;
+}
+
+vector<PostPtr> PostsManager::getAuthorsPage(const vector<string>& authors, size_t limit, const PostKey& before) const {
+    // Each author's next (older) key and its position in their index;
+    // select() steps back one position at a time
+    struct Head {
+        PostKey key;
+        const PostIndex* index;
+        size_t position;
+    };
+    auto older = [](const Head& a, const Head& b) { return a.key < b.key; };
+
+    vector<PostPtr> page;
+    shared_lock<shared_mutex> lock(indexMutex);
+    vector<Head> heads;
+    for (const string& author : authors) {
+        auto it = authorIndex.find(author);
+        if (it == authorIndex.end()) continue;
+        size_t position = it->second.rank(before);
+        if (position > 0) {
+            heads.push_back({*it->second.select(position - 1), &it->second, position - 1});
         }
     }
-    return nullptr;
+    make_heap(heads.begin(), heads.end(), older);
+    while (!heads.empty() && page.size() < limit) {
+        pop_heap(heads.begin(), heads.end(), older);
+        Head& head = heads.back();
+        if (PostPtr post = posts.find(head.key.id)) {
+            page.push_back(post);
+        }
+        if (head.position == 0) {
+            heads.pop_back();
+            continue;
+        }
+        head.key = *head.index->select(--head.position);
+        push_heap(heads.begin(), heads.end(), older);
+    }
+    return page;
 }
 
-void Timeline::addReaction(int postId, const string& username, const string& reaction) {
-    Post* post = findPost(postId);
+bool Timeline::addReaction(int postId, const string& username, const string& reaction) {
+    PostPtr post = findPost(postId);
     if (!post) {
         throw runtime_error("Post not found");
     }
-    
-    // Toggle reaction - if user already reacted, remove it; otherwise add it
-    if (post->hasReaction(username)) {
-        post->removeReaction(username);
+    const string type = reaction.empty() ? "like" : reaction;
+    if (!ReactionSet::isValidType(type)) {
+        throw runtime_error("Invalid reaction type");
+    }
+    unique_lock<shared_mutex> lock(postLock(postId));
+
+    // Toggle reaction - the same type again removes it, another type replaces it
+    bool on = post->toggleReaction(username, type);
+
+    // Log the resulting state rather than the toggle so replay stays idempotent
+    journal.append({{"op", "reaction"}, {"postId", postId}, {"user", username}, {"type", type}, {"on", on}});
+    return on;
+}
+
+//--------------------------------------------------------------------------
+// Home timelines
+//--------------------------------------------------------------------------
+vector<string> Timeline::friendsOf(const string& username) const {
+    if (!friendsManager) return {};
+    try {
+        return friendsManager->getFriendList(username);
+    } catch (const exception&) {
+        return {}; // e.g. posts left behind by a user who no longer exists
+    }
+}
+
+void Timeline::attachFriends(const FriendsManager& friends) {
+    friendsManager = &friends;
+    homeTimelines.clear();
+    // Slots are in creation order, so rings fill oldest to newest
+    PostsSnapshot current = getSnapshot();
+    unordered_map<string, vector<string>> friendLists;
+    for (const auto& post : *current) {
+        const string owner = post->getPostOwner();
+        auto it = friendLists.find(owner);
+        if (it == friendLists.end()) {
+            it = friendLists.emplace(owner, friendsOf(owner)).first;
+        }
+        homeTimelines.addPost(owner, post->getPostId(), it->second);
+    }
+}
+
+void Timeline::onPostAdded(const Post& post) {
+    homeTimelines.addPost(post.getPostOwner(), post.getPostId(), friendsOf(post.getPostOwner()));
+}
+
+void Timeline::onPostRemoved(const Post& post) {
+    homeTimelines.removePost(post.getPostOwner(), post.getPostId(), friendsOf(post.getPostOwner()));
+}
+
+void Timeline::onFriendshipChanged(const string& userA, const string& userB, bool added) {
+    if (added) {
+        homeTimelines.addFriendship(userA, userB);
     } else {
-        post->addReaction(username);
+        homeTimelines.removeFriendship(userA, userB);
     }
-    
-    // Save changes to file
-    savePosts();
 }
 
-// Add this new method to the Timeline class
-vector<Post> Timeline::getFilteredPosts(const string& username, const FriendsManager& friendsManager) {
-    vector<Post> filteredPosts;
-    for (const auto& post : PostsVec) {
-        // Include posts if they are from the user or from their friends
-        if (post.getPostOwner() == username || friendsManager.areFriends(username, post.getPostOwner())) {
-            filteredPosts.push_back(post);
+vector<PostPtr> Timeline::getHomeFeed(const string& username, size_t limit, const PostKey& before) const {
+    vector<string> friends = friendsOf(username);
+    vector<PostPtr> feed;
+    int floor = 0;
+    int beforeId = before.id;
+    // Ids of deleted posts and of ex-friends' posts are skipped, so keep
+    // reading until the page is full or the rings have nothing more
+    bool exhausted = false;
+    while (feed.size() < limit && !exhausted) {
+        size_t wanted = limit - feed.size();
+        vector<int> ids = homeTimelines.read(username, friends, wanted, beforeId, floor);
+        exhausted = ids.size() < wanted;
+        for (int id : ids) {
+            beforeId = id;
+            PostPtr post = findPost(id);
+            if (!post) continue; // deleted since it was fanned out
+            const string owner = post->getPostOwner();
+            if (owner != username && !binary_search(friends.begin(), friends.end(), owner)) continue;
+            feed.push_back(post);
         }
     }
-    // Sort by timestamp, newest first
-    sort(filteredPosts.begin(), filteredPosts.end(), 
-        [](const Post& a, const Post& b) {
-            return a.getPostTimes() > b.getPostTimes();
-        });
+
+    // The rings ran out above 'floor' but may have dropped older posts:
+    // carry on from the author indexes of everyone in the feed
+    if (exhausted && floor > 0 && feed.size() < limit) {
+        PostKey from = before;
+        if (!feed.empty()) from = PostKey{feed.back()->getPostTimes(), feed.back()->getPostId()};
+        friends.push_back(username);
+        for (PostPtr& post : getAuthorsPage(friends, limit - feed.size(), from)) {
+            feed.push_back(move(post));
+        }
+    }
+    return feed;
+}
+
+vector<Post> Timeline::getFilteredPosts(const string& username) {
+    vector<Post> filteredPosts;
+    // Newest first from the user's home timeline, then the author indexes
+    for (const auto& post : getHomeFeed(username, SIZE_MAX)) {
+        shared_lock<shared_mutex> lock(postLock(post->getPostId()));
+        filteredPosts.push_back(*post);
+    }
     return filteredPosts;
 }
 